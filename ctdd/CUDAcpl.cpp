@@ -5,6 +5,10 @@ using namespace CUDAcpl;
 
 
 CUDAcpl::Tensor CUDAcpl::reciprocal_without_zero(const Tensor& a) {
+#ifdef CUDACPL_NATIVE_COMPLEX
+	auto&& a_cpl = as_complex(a);
+	return as_real(torch::where(a_cpl != 0, a_cpl.reciprocal(), torch::zeros_like(a_cpl)));
+#else
 	auto&& a_dim = a.dim() - 1;
 	auto&& a_real = a.select(a_dim, 0);
 	auto&& a_imag = a.select(a_dim, 1);
@@ -14,10 +18,14 @@ CUDAcpl::Tensor CUDAcpl::reciprocal_without_zero(const Tensor& a) {
 		denominator, torch::ones_like(denominator, tensor_opt));
 	denominator = denominator.unsqueeze(a_dim).expand_as(res);
 	return res / denominator;
+#endif
 }
 
 Tensor CUDAcpl::tensordot(const Tensor& a, const Tensor& b,
 	c10::IntArrayRef dim_self, c10::IntArrayRef dim_other) {
+#ifdef CUDACPL_NATIVE_COMPLEX
+	return as_real(torch::tensordot(as_complex(a), as_complex(b), dim_self, dim_other));
+#else
 	auto&& a_dim = a.dim() - 1;
 	auto&& a_real = a.select(a_dim, 0);
 	auto&& a_imag = a.select(a_dim, 1);
@@ -29,11 +37,15 @@ Tensor CUDAcpl::tensordot(const Tensor& a, const Tensor& b,
 	auto&& res_imag = torch::tensordot(a_real, b_imag, dim_self, dim_other) +
 		torch::tensordot(a_imag, b_real, dim_self, dim_other);
 	return torch::stack({ res_real, res_imag }, res_real.dim());
+#endif
 }
 
 Tensor CUDAcpl::einsum(c10::string_view equation, at::TensorList tensors) {
 	auto&& a = tensors[0];
 	auto&& b = tensors[1];
+#ifdef CUDACPL_NATIVE_COMPLEX
+	return as_real(torch::einsum(equation, { as_complex(a), as_complex(b) }));
+#else
 	auto&& a_dim = a.dim() - 1;
 	auto&& a_real = a.select(a_dim, 0);
 	auto&& a_imag = a.select(a_dim, 1);
@@ -43,4 +55,5 @@ Tensor CUDAcpl::einsum(c10::string_view equation, at::TensorList tensors) {
 	auto&& res_real = torch::einsum(equation, { a_real, b_real }) - torch::einsum(equation, { a_imag, b_imag });
 	auto&& res_imag = torch::einsum(equation, { a_real, b_imag }) + torch::einsum(equation, { a_imag, b_real });
 	return torch::stack({ res_real, res_imag }, res_real.dim());
+#endif
 }
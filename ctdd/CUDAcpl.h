@@ -1,5 +1,8 @@
 /*
 * It is a small package to implement the use of complex number in torch, by an extra inner dimension.
+* 
+* Define CUDACPL_NATIVE_COMPLEX to conduct the arithmetic on the native complex dtype of torch instead,
+* which views the inner dimension as interleaved complex numbers and calls one fused kernel per operation.
 */
 
 #pragma once
@@ -12,6 +15,14 @@ namespace CUDAcpl {
 	// The CUDA complex tensor.
 	typedef torch::Tensor Tensor;
 
+	// whether T is a std::complex scalar (of any precision)
+	template <typename T>
+	struct is_scalar : std::false_type {};
+	template <typename T>
+	struct is_scalar<std::complex<T>> : std::true_type {};
+	template <typename T>
+	constexpr bool is_scalar_v = is_scalar<T>::value;
+
 	extern c10::TensorOptions tensor_opt;
 
 	inline void reset(bool device_cuda, bool double_type) noexcept {
@@ -42,18 +53,68 @@ namespace CUDAcpl {
 			t.index({ "...",1 }).cpu().item().toDouble());
 	}
 
+#ifdef CUDACPL_NATIVE_COMPLEX
+	/// <summary>
+	/// View the tensor as one of the native complex dtype, without copying when the layout allows.
+	/// </summary>
+	/// <param name="t"></param>
+	/// <returns></returns>
+	inline Tensor as_complex(const Tensor& t) {
+		bool viewable = t.stride(t.dim() - 1) == 1 && t.storage_offset() % 2 == 0;
+		for (int64_t i = 0; viewable && i < t.dim() - 1; i++) {
+			viewable = t.stride(i) % 2 == 0;
+		}
+		return torch::view_as_complex(viewable ? t : t.contiguous());
+	}
+
+	/// <summary>
+	/// Convert the tensor of the native complex dtype back to the one with the extra inner dimension.
+	/// </summary>
+	/// <param name="t"></param>
+	/// <returns></returns>
+	inline Tensor as_real(const Tensor& t) {
+		return torch::view_as_real(t);
+	}
+
+	/// <summary>
+	/// Multiply the tensor of the native complex dtype by the scalar, in the precision of the tensor.
+	/// </summary>
+	/// <param name="t"></param>
+	/// <param name="s"></param>
+	/// <returns></returns>
+	template <typename S>
+	inline Tensor mul_scalar_complex(const Tensor& t, const std::complex<S>& s) {
+		switch (t.scalar_type()) {
+		case c10::ScalarType::ComplexFloat:
+			return t * c10::complex<float>((float)s.real(), (float)s.imag());
+		case c10::ScalarType::ComplexDouble:
+			return t * c10::complex<double>((double)s.real(), (double)s.imag());
+		default:
+			throw std::invalid_argument("the tensor is not of a complex dtype.");
+		}
+	}
+#endif
+
 	inline Tensor norm(const Tensor& t) {
+#ifdef CUDACPL_NATIVE_COMPLEX
+		return t.square().sum(t.dim() - 1);
+#else
 		auto&& t_dim = t.dim() - 1;
 		auto&& t_real = t.select(t_dim, 0);
 		auto&& t_imag = t.select(t_dim, 1);
 		return t_real * t_real + t_imag * t_imag;
+#endif
 	}
 
 	inline Tensor conj(const Tensor& t) {
+#ifdef CUDACPL_NATIVE_COMPLEX
+		return as_real(torch::conj_physical(as_complex(t)));
+#else
 		auto&& t_dim = t.dim() - 1;
 		auto&& t_real = t.select(t_dim, 0);
 		auto&& t_imag = t.select(t_dim, 1);
 		return torch::stack({ t_real, -t_imag }, t_dim);
+#endif
 	}
 
 	inline Tensor ones(c10::IntArrayRef size) {
@@ -87,6 +148,20 @@ namespace CUDAcpl {
 
 	template <typename W1, typename W2>
 	auto mul_element_wise(const W1& a, const W2& b) {
+#ifdef CUDACPL_NATIVE_COMPLEX
+		if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, CUDAcpl::Tensor>) {
+			return as_real(as_complex(a) * as_complex(b));
+		}
+		else if constexpr (is_scalar_v<W1> && std::is_same_v<W2, CUDAcpl::Tensor>) {
+			return as_real(mul_scalar_complex(as_complex(b), a));
+		}
+		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && is_scalar_v<W2>) {
+			return as_real(mul_scalar_complex(as_complex(a), b));
+		}
+		else {
+			return a * b;
+		}
+#else
 		if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, CUDAcpl::Tensor>) {
 			auto&& a_dim = a.dim() - 1;
 			auto&& a_real = a.select(a_dim, 0);
@@ -96,7 +171,7 @@ namespace CUDAcpl {
 			auto&& b_imag = b.select(b_dim, 1);
 			return torch::stack({ a_real * b_real - a_imag * b_imag, a_real * b_imag + a_imag * b_real }, a_dim);
 		}
-		else if constexpr (std::is_same_v<W1, Complex> && std::is_same_v<W2, CUDAcpl::Tensor>) {
+		else if constexpr (is_scalar_v<W1> && std::is_same_v<W2, CUDAcpl::Tensor>) {
 			auto&& dim = b.dim() - 1;
 			auto&& b_real = b.select(dim, 0);
 			auto&& b_imag = b.select(dim, 1);
@@ -104,7 +179,7 @@ namespace CUDAcpl {
 			auto&& res_imag = b_real * a.imag() + b_imag * a.real();
 			return torch::stack({ res_real, res_imag }, dim);
 		}
-		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, Complex>) {
+		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && is_scalar_v<W2>) {
 			auto&& dim = a.dim() - 1;
 			auto&& a_real = a.select(dim, 0);
 			auto&& a_imag = a.select(dim, 1);
@@ -115,6 +190,7 @@ namespace CUDAcpl {
 		else {
 			return a * b;
 		}
+#endif
 	}
 
 	/// <summary>
@@ -0,0 +1,85 @@
+#pragma once
+#include "manage.hpp"
+
+/// <summary>
+/// The asynchronous variants of the long-running operations, which return immediately.
+/// The operations are executed one at a time by the dispatcher thread (mng::p_async_pool) with the engine lock held,
+/// while the parallel iteration inside still runs on the thread pool of the engine. The results are allocated with the
+/// lock held, for the tdds are registered globally. Note that the operands are taken by reference, and should be kept
+/// alive until the operations finish, and that other calls into the engine should hold mng::engine_mutex meanwhile.
+/// </summary>
+namespace async_ops {
+
+	/// <summary>
+	/// Submit the operation f (returning TDD<W>), and call on_done(p_res, p_error) on the dispatcher thread
+	/// after the engine lock is released, where p_error is the exception thrown (nullptr for success).
+	/// </summary>
+	template <class W, class F, class D>
+	void submit(F&& f, D&& on_done) {
+		mng::p_async_pool->enqueue([f = std::forward<F>(f), on_done = std::forward<D>(on_done)]() mutable {
+			std::unique_ptr<tdd::TDD<W>> p_res;
+			std::exception_ptr p_error;
+			{
+				std::lock_guard<std::recursive_mutex> lock(mng::engine_mutex);
+				try {
+					p_res.reset(new tdd::TDD<W>(f()));
+				}
+				catch (...) {
+					p_error = std::current_exception();
+				}
+			}
+			on_done(std::move(p_res), p_error);
+			});
+	}
+
+	/// <summary>
+	/// Submit the operation f (returning TDD<W>), and return the future of the result.
+	/// </summary>
+	template <class W, class F>
+	std::future<std::unique_ptr<tdd::TDD<W>>> submit(F&& f) {
+		auto&& p_promise = std::make_shared<std::promise<std::unique_ptr<tdd::TDD<W>>>>();
+		auto res = p_promise->get_future();
+		submit<W>(std::forward<F>(f), [p_promise](std::unique_ptr<tdd::TDD<W>>&& p_res, std::exception_ptr p_error) {
+			if (p_error) {
+				p_promise->set_exception(p_error);
+			}
+			else {
+				p_promise->set_value(std::move(p_res));
+			}
+			});
+		return res;
+	}
+
+	template <class W>
+	inline std::future<std::unique_ptr<tdd::TDD<W>>> as_tensor(const CUDAcpl::Tensor& t, int dim_parallel,
+		const std::vector<int64_t>& storage_order, ctrl::Controller* p_ctrl = nullptr) {
+		return submit<W>([t, dim_parallel, storage_order, p_ctrl]() {
+			return tdd::TDD<W>::as_tensor(t, dim_parallel, storage_order, p_ctrl);
+			});
+	}
+
+	template <class W>
+	inline std::future<std::unique_ptr<tdd::TDD<W>>> sum(const tdd::TDD<W>& a, const tdd::TDD<W>& b,
+		ctrl::Controller* p_ctrl = nullptr) {
+		return submit<W>([&a, &b, p_ctrl]() {
+			return tdd::TDD<W>::sum(a, b, p_ctrl);
+			});
+	}
+
+	template <class W>
+	inline std::future<std::unique_ptr<tdd::TDD<W>>> trace(const tdd::TDD<W>& a, const cache::pair_cmd& indices,
+		ctrl::Controller* p_ctrl = nullptr) {
+		return submit<W>([&a, indices, p_ctrl]() {
+			return a.trace(indices, p_ctrl);
+			});
+	}
+
+	template <typename W1, typename W2>
+	inline std::future<std::unique_ptr<tdd::TDD<weight::W_C<W1, W2>>>> tensordot(const tdd::TDD<W1>& a, const tdd::TDD<W2>& b,
+		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b,
+		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false, ctrl::Controller* p_ctrl = nullptr) {
+		return submit<weight::W_C<W1, W2>>([&a, &b, ils_a, ils_b, rearrangement, parallel_tensor, p_ctrl]() {
+			return tdd::tensordot<W1, W2>(a, b, ils_a, ils_b, rearrangement, parallel_tensor, p_ctrl);
+			});
+	}
+}
@@ -9,21 +9,28 @@ namespace node {
 	struct weightednode;
 	template <class W>
 	struct wnode_cache;
+	// the successor list. It is stored inline for two successors (the qubit case), so a range-2 node needs no extra allocation.
 	template <class W>
-	using succ_ls = std::vector<weightednode<W>>;
+	using succ_ls = boost::container::small_vector<weightednode<W>, 2>;
 }
 
 
 namespace cache {
+	// the list in unique table keys, stored inline for two successors as well
+	template <class T>
+	using key_ls = boost::container::small_vector<T, 2>;
+
 	// the type for unique table
 	template <class W>
 	struct unique_table_key {
 		int order;
 		// real for <weight>, data for <tensor> (encode  in sequence)
-		std::vector<weight::WCode> code1;
+		key_ls<weight::WCode> code1;
 		// imag for <weight>, shape for <tensor>
-		std::vector<weight::WCode> code2;
-		std::vector<const node::Node<W>*> nodes;
+		key_ls<weight::WCode> code2;
+		key_ls<const node::Node<W>*> nodes;
+		// calculated once at construction, for the key is hashed again at every rehash
+		std::size_t hash;
 
 		/// <summary>
 		/// Construction of a unique_table key (complex version)
@@ -35,30 +42,52 @@ namespace cache {
 		unique_table_key(int _order, const node::succ_ls<W>& successors) noexcept {
 			if constexpr (std::is_same_v<W, wcomplex>) {
 				order = _order;
-				code1 = std::vector<weight::WCode>(successors.size());
-				code2 = std::vector<weight::WCode>(successors.size());
-				nodes = std::vector<const node::Node<wcomplex>*>(successors.size());
+				code1 = key_ls<weight::WCode>(successors.size());
+				code2 = key_ls<weight::WCode>(successors.size());
+				nodes = key_ls<const node::Node<wcomplex>*>(successors.size());
+				if (successors.size() == 2) {
+					// the qubit case, unrolled
+					weight::get_int_key(code1.data(), successors[0].weight.real());
+					weight::get_int_key(code2.data(), successors[0].weight.imag());
+					weight::get_int_key(code1.data() + 1, successors[1].weight.real());
+					weight::get_int_key(code2.data() + 1, successors[1].weight.imag());
+					nodes[0] = successors[0].get_node();
+					nodes[1] = successors[1].get_node();
+					hash = calculate_hash();
+					return;
+				}
 				for (int i = 0; i < successors.size(); i++) {
 					weight::get_int_key(code1.data() + i, successors[i].weight.real());
 					weight::get_int_key(code2.data() + i, successors[i].weight.imag());
 					nodes[i] = successors[i].get_node();
 				}
 			}
+			else if constexpr (std::is_same_v<W, weight::qomega>) {
+				// exact codes, stored in code1 only
+				order = _order;
+				code1 = key_ls<weight::WCode>(weight::EXACT_KEY_SIZE * successors.size());
+				nodes = key_ls<const node::Node<weight::qomega>*>(successors.size());
+				for (int i = 0; i < successors.size(); i++) {
+					weight::get_int_key(code1.data() + i * weight::EXACT_KEY_SIZE, successors[i].weight);
+					nodes[i] = successors[i].get_node();
+				}
+			}
 			else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 				order = _order;
 				auto numel = successors[0].weight.numel();
-				code1 = std::vector<weight::WCode>(numel * successors.size());
-				nodes = std::vector<const node::Node<CUDAcpl::Tensor>*>(successors.size());
+				code1 = key_ls<weight::WCode>(numel * successors.size());
+				nodes = key_ls<const node::Node<CUDAcpl::Tensor>*>(successors.size());
 				for (int i = 0; i < successors.size(); i++) {
 					weight::get_int_key(code1.data() + i * numel, successors[i].weight);
 					nodes[i] = successors[i].get_node();
 				}
-				code2 = std::vector<weight::WCode>(successors[0].weight.dim() - 1);
+				code2 = key_ls<weight::WCode>(successors[0].weight.dim() - 1);
 				auto&& sizes = successors[0].weight.sizes();
 				for (int i = 0; i < successors[0].weight.dim() - 1; i++) {
 					code2[i] = sizes[i];
 				}
 			}
+			hash = calculate_hash();
 		}
 
 		unique_table_key(const unique_table_key& other) noexcept {
@@ -66,6 +95,7 @@ namespace cache {
 			code1 = other.code1;
 			code2 = other.code2;
 			nodes = other.nodes;
+			hash = other.hash;
 		}
 
 		unique_table_key& operator =(unique_table_key&& other) noexcept {
@@ -73,13 +103,42 @@ namespace cache {
 			code1 = std::move(other.code1);
 			code2 = std::move(other.code2);
 			nodes = std::move(other.nodes);
+			hash = other.hash;
 			return *this;
 		}
+
+		inline std::size_t calculate_hash() const noexcept {
+			std::size_t seed = 0;
+			boost::hash_combine(seed, order);
+			if constexpr (std::is_same_v<W, wcomplex>) {
+				if (nodes.size() == 2) {
+					// the qubit case, unrolled (the same hash as the loops below)
+					boost::hash_combine(seed, code1[0]);
+					boost::hash_combine(seed, code1[1]);
+					boost::hash_combine(seed, code2[0]);
+					boost::hash_combine(seed, code2[1]);
+					boost::hash_combine(seed, nodes[0]);
+					boost::hash_combine(seed, nodes[1]);
+					return seed;
+				}
+			}
+			for (const auto& code : code1) {
+				boost::hash_combine(seed, code);
+			}
+			for (const auto& code : code2) {
+				boost::hash_combine(seed, code);
+			}
+			for (const auto& code : nodes) {
+				boost::hash_combine(seed, code);
+			}
+			return seed;
+		}
 	};
 
 	template <class W>
 	inline bool operator == (const unique_table_key<W>& a, const unique_table_key<W>& b) noexcept {
-		if (a.order != b.order) {
+		// different hashes reject most of the unequal keys at once
+		if (a.hash != b.hash || a.order != b.order) {
 			return false;
 		}
 		// compare code2 first, because for <tensor> case it stores the shape information
@@ -97,22 +156,54 @@ namespace cache {
 
 	template <class W>
 	inline std::size_t hash_value(const unique_table_key<W>& key) noexcept {
-		std::size_t seed = 0;
-		boost::hash_combine(seed, key.order);
-		for (const auto& code : key.code1) {
-			boost::hash_combine(seed, code);
+		return key.hash;
+	}
+
+	template <typename W>
+	using unique_table = boost::unordered_map<unique_table_key<W>, node::Node<W>*>;
+
+
+	/// <summary>
+	/// The key of a contiguous block of successors, used to deduplicate identical sub-blocks when a tdd is built bottom-up.
+	/// The weights are compared exactly, so the blocks of equal keys always normalize to the same weighted node.
+	/// </summary>
+	template <class W>
+	struct block_key {
+		// [borrowed]
+		const node::weightednode<W>* p_block;
+		int64_t range;
+		std::size_t hash;
+
+		block_key(const node::weightednode<W>* _p_block, int64_t _range) noexcept {
+			p_block = _p_block;
+			range = _range;
+			std::size_t seed = 0;
+			for (int64_t i = 0; i < range; i++) {
+				boost::hash_combine(seed, p_block[i].get_node());
+				boost::hash_combine(seed, p_block[i].weight.real());
+				boost::hash_combine(seed, p_block[i].weight.imag());
+			}
+			hash = seed;
 		}
-		for (const auto& code : key.code2) {
-			boost::hash_combine(seed, code);
+	};
+
+	template <class W>
+	inline bool operator == (const block_key<W>& a, const block_key<W>& b) noexcept {
+		if (a.hash != b.hash || a.range != b.range) {
+			return false;
 		}
-		for (const auto& code : key.nodes) {
-			boost::hash_combine(seed, code);
+		for (int64_t i = 0; i < a.range; i++) {
+			if (a.p_block[i].get_node() != b.p_block[i].get_node() || a.p_block[i].weight != b.p_block[i].weight) {
+				return false;
+			}
 		}
-		return seed;
+		return true;
 	}
 
-	template <typename W>
-	using unique_table = boost::unordered_map<unique_table_key<W>, node::Node<W>*>;
+	template <class W>
+	inline std::size_t hash_value(const block_key<W>& key) noexcept {
+		return key.hash;
+	}
 
 
 
@@ -185,6 +276,8 @@ namespace cache {
 		const node::Node<W>* p_node_2;
 		std::vector<weight::WCode> nweight2_code1;
 		std::vector<weight::WCode> nweight2_code2;
+		// calculated once at construction
+		std::size_t hash;
 
 		//sum_key() {};
 		
@@ -222,6 +315,15 @@ namespace cache {
 					weight::get_int_key(nweight2_code2.data(), weight_a.imag());
 				}
 			}
+			else if constexpr (std::is_same_v<W, weight::qomega>) {
+				// exact codes, stored in code1 only
+				p_node_1 = p_node_a < p_node_b ? p_node_a : p_node_b;
+				p_node_2 = p_node_a < p_node_b ? p_node_b : p_node_a;
+				nweight1_code1 = std::vector<weight::WCode>(weight::EXACT_KEY_SIZE);
+				weight::get_int_key(nweight1_code1.data(), p_node_a < p_node_b ? weight_a : weight_b);
+				nweight2_code1 = std::vector<weight::WCode>(weight::EXACT_KEY_SIZE);
+				weight::get_int_key(nweight2_code1.data(), p_node_a < p_node_b ? weight_b : weight_a);
+			}
 			else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 				if (p_node_a < p_node_b) {
 					p_node_1 = p_node_a;
@@ -261,6 +363,7 @@ namespace cache {
 					nweight2_code2 = std::vector<weight::WCode>();
 				}
 			}
+			hash = calculate_hash();
 		}
 		
 		sum_key(const sum_key& other) noexcept {
@@ -270,6 +373,7 @@ namespace cache {
 			p_node_2 = other.p_node_2;
 			nweight2_code1 = other.nweight2_code1;
 			nweight2_code2 = other.nweight2_code2;
+			hash = other.hash;
 		}
 
 		sum_key& operator =(sum_key&& other) noexcept {
@@ -279,9 +383,29 @@ namespace cache {
 			p_node_2 = other.p_node_2;
 			nweight2_code1 = std::move(other.nweight2_code1);
 			nweight2_code2 = std::move(other.nweight2_code2);
+			hash = other.hash;
 			return *this;
 		}
 
+		inline std::size_t calculate_hash() const noexcept {
+			std::size_t seed = 0;
+			boost::hash_combine(seed, p_node_1);
+			boost::hash_combine(seed, p_node_2);
+			for (const auto& code : nweight1_code1) {
+				boost::hash_combine(seed, code);
+			}
+			for (const auto& code : nweight1_code2) {
+				boost::hash_combine(seed, code);
+			}
+			for (const auto& code : nweight2_code1) {
+				boost::hash_combine(seed, code);
+			}
+			for (const auto& code : nweight2_code2) {
+				boost::hash_combine(seed, code);
+			}
+			return seed;
+		}
+
 		inline bool is_garbage() const noexcept {
 			return node::Node<W>::is_garbage(p_node_1) || node::Node<W>::is_garbage(p_node_2);
 		}
@@ -289,7 +413,7 @@ namespace cache {
 
 	template <class W>
 	inline bool operator == (const sum_key<W>& a, const sum_key<W>& b) noexcept {
-		return a.p_node_1 == b.p_node_1 && a.p_node_2 == b.p_node_2 &&
+		return a.hash == b.hash && a.p_node_1 == b.p_node_1 && a.p_node_2 == b.p_node_2 &&
 			a.nweight1_code1 == b.nweight1_code1 &&
 			a.nweight1_code2 == b.nweight1_code2 &&
 			a.nweight2_code1 == b.nweight2_code1 &&
@@ -298,22 +422,7 @@ namespace cache {
 
 	template <class W>
 	inline std::size_t hash_value(const sum_key<W>& key) noexcept {
-		std::size_t seed = 0;
-		boost::hash_combine(seed, key.p_node_1);
-		boost::hash_combine(seed, key.p_node_2);
-		for (const auto& code : key.nweight1_code1) {
-			boost::hash_combine(seed, code);
-		}
-		for (const auto& code : key.nweight1_code2) {
-			boost::hash_combine(seed, code);
-		}
-		for (const auto& code : key.nweight2_code1) {
-			boost::hash_combine(seed, code);
-		}
-		for (const auto& code : key.nweight2_code2) {
-			boost::hash_combine(seed, code);
-		}
-		return seed;
+		return key.hash;
 	}
 
 	template <class W>
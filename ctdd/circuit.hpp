@@ -0,0 +1,194 @@
+#pragma once
+#include "tdd.hpp"
+#include "gates.hpp"
+
+/// <summary>
+/// The simulation of whole circuits, where the gates are constructed, ordered and contracted in C++.
+/// The qubit q of a circuit unitary corresponds to the indices out_q (q) and in_q (num_qubits + q), as in the gate library,
+/// and to the index q of a circuit state.
+/// </summary>
+namespace circuit {
+
+	/// <summary>
+	/// A gate applied in the circuit.
+	/// </summary>
+	template <class W>
+	struct operation {
+		// the qubits acted on, where the first one is the most significant bit of the matrix
+		std::vector<int64_t> qubits;
+
+		// the matrix of 2^k x 2^k (k qubits) in row-major order
+		std::vector<W> matrix;
+	};
+
+	/// <summary>
+	/// Return the matrix of the controlled gate in row-major order, where the last qubit is the target.
+	/// </summary>
+	inline std::vector<wcomplex> controlled_matrix(const std::array<wcomplex, 4>& u, int num_controls) {
+		int64_t dim = (int64_t)2 << num_controls;
+		std::vector<wcomplex> res(dim * dim, 0.);
+		for (int64_t i = 0; i < dim - 2; i++) {
+			res[i * dim + i] = 1.;
+		}
+		for (int r = 0; r < 2; r++) {
+			for (int c = 0; c < 2; c++) {
+				res[(dim - 2 + r) * dim + dim - 2 + c] = u[2 * r + c];
+			}
+		}
+		return res;
+	}
+
+	/// <summary>
+	/// Return the matrix of the named gate in row-major order.
+	/// The supported names are x, y, z, h, s, sdg, t, tdg, p (theta), rx (theta), ry (theta), rz (theta), cx, cz, swap and ccx.
+	/// </summary>
+	/// <param name="name"></param>
+	/// <param name="params">the rotation angles</param>
+	/// <returns></returns>
+	inline std::vector<wcomplex> named_matrix(const std::string& name, const std::vector<double>& params) {
+		bool rotation = name == "p" || name == "rx" || name == "ry" || name == "rz";
+		if (params.size() != (rotation ? 1 : 0)) {
+			throw std::invalid_argument("the gate " + name + " takes " + (rotation ? "1 parameter." : "no parameters."));
+		}
+
+		std::array<wcomplex, 4> u;
+		double theta = params.empty() ? 0. : params[0];
+		const double r = 1. / std::sqrt(2.);
+		const wcomplex i(0., 1.);
+		if (name == "x") u = gates::matrix(0., 1., 1., 0.);
+		else if (name == "y") u = gates::matrix(0., -i, i, 0.);
+		else if (name == "z") u = gates::matrix(1., 0., 0., -1.);
+		else if (name == "h") u = gates::matrix(r, r, r, -r);
+		else if (name == "s") u = gates::matrix(1., 0., 0., i);
+		else if (name == "sdg") u = gates::matrix(1., 0., 0., -i);
+		else if (name == "t") u = gates::matrix(1., 0., 0., gates::e_i_theta(std::atan(1.)));
+		else if (name == "tdg") u = gates::matrix(1., 0., 0., gates::e_i_theta(-std::atan(1.)));
+		else if (name == "p") u = gates::matrix(1., 0., 0., gates::e_i_theta(theta));
+		else if (name == "rx") u = gates::matrix(std::cos(theta / 2), wcomplex(0., -std::sin(theta / 2)), wcomplex(0., -std::sin(theta / 2)), std::cos(theta / 2));
+		else if (name == "ry") u = gates::matrix(std::cos(theta / 2), -std::sin(theta / 2), std::sin(theta / 2), std::cos(theta / 2));
+		else if (name == "rz") u = gates::matrix(gates::e_i_theta(-theta / 2), 0., 0., gates::e_i_theta(theta / 2));
+		else if (name == "cx") return controlled_matrix(gates::matrix(0., 1., 1., 0.), 1);
+		else if (name == "cz") return controlled_matrix(gates::matrix(1., 0., 0., -1.), 1);
+		else if (name == "ccx") return controlled_matrix(gates::matrix(0., 1., 1., 0.), 2);
+		else if (name == "swap") return { 1., 0., 0., 0., 0., 0., 1., 0., 0., 1., 0., 0., 0., 0., 0., 1. };
+		else {
+			throw std::invalid_argument("unknown gate: " + name + ".");
+		}
+		return std::vector<wcomplex>(u.begin(), u.end());
+	}
+
+	/// <summary>
+	/// Return the operation of the named gate.
+	/// </summary>
+	inline operation<wcomplex> named(const std::string& name, const std::vector<int64_t>& qubits, const std::vector<double>& params = {}) {
+		return { qubits, named_matrix(name, params) };
+	}
+
+	/// <summary>
+	/// Return the tdd of the state |0...0> on num_qubits qubits.
+	/// </summary>
+	template <class W>
+	tdd::TDD<W> zero_state(int num_qubits) {
+		if (num_qubits < 1) {
+			throw std::invalid_argument("the state should be of at least one qubit.");
+		}
+		auto&& zero = gates::terminal(weight::zeros<W>({}));
+		auto&& res = gates::terminal(weight::ones<W>({}));
+		for (int q = num_qubits - 1; q >= 0; q--) {
+			res = wnode::normalize<W>(weight::ones<W>({}), q, node::succ_ls<W>{ res, zero });
+		}
+		std::vector<int64_t> data_shape(num_qubits, 2);
+		std::vector<int64_t> storage_order(num_qubits);
+		for (int q = 0; q < num_qubits; q++) {
+			storage_order[q] = q;
+		}
+		return tdd::TDD<W>::from_wnode(std::move(res), data_shape, storage_order);
+	}
+
+	/// <summary>
+	/// Apply the operation on the circuit tdd (the unitary or the state), where the index q is the output of qubit q.
+	/// The gate is constructed in the storage order following the levels of its qubits in u, so that the result
+	/// keeps the storage order of u, and the indices are permuted back afterwards.
+	/// </summary>
+	template <class W>
+	tdd::TDD<W> apply_gate(const tdd::TDD<W>& u, const operation<W>& op) {
+		int k = op.qubits.size();
+
+		// sort the gate qubits by their levels in u
+		std::vector<int64_t> sorted(k);
+		for (int j = 0; j < k; j++) {
+			sorted[j] = j;
+		}
+		std::sort(sorted.begin(), sorted.end(),
+			[&u, &op](int64_t a, int64_t b) {
+				return u.inversed_order()[op.qubits[a]] < u.inversed_order()[op.qubits[b]];
+			});
+		std::vector<int64_t> gate_order(2 * k);
+		for (int m = 0; m < k; m++) {
+			gate_order[2 * m] = sorted[m];
+			gate_order[2 * m + 1] = k + sorted[m];
+		}
+		std::vector<int64_t> gate_shape(2 * k, 2);
+		auto&& gate = tdd::TDD<W>::as_values(op.matrix, gate_shape, gate_order);
+
+		// contract the inputs of the gate with the outputs of u, at the levels of u
+		std::vector<int64_t> ils_gate(k), ils_u(k);
+		for (int j = 0; j < k; j++) {
+			ils_gate[j] = k + j;
+			ils_u[j] = op.qubits[j];
+		}
+		std::vector<int> rearrangement(u.dim_data());
+		for (int l = 0; l < u.dim_data(); l++) {
+			auto&& index = u.storage_order()[l];
+			rearrangement[l] = std::find(ils_u.begin(), ils_u.end(), index) != ils_u.end();
+		}
+		auto&& res = tdd::tensordot<W, W>(gate, u, ils_gate, ils_u, rearrangement);
+
+		// the result indices are (gate outputs, remained indices of u)
+		std::vector<int64_t> permutation(u.dim_data());
+		for (int j = 0; j < k; j++) {
+			permutation[op.qubits[j]] = j;
+		}
+		auto&& remained = tdd::remained_indices(u.dim_data(), ils_u);
+		for (int r = 0; r < remained.size(); r++) {
+			permutation[remained[r]] = k + r;
+		}
+		return res.permute(permutation);
+	}
+
+	/// <summary>
+	/// Return the tdd of the circuit: the unitary, or the state resulting from |0...0> if state is true.
+	/// The operation is supervised by p_ctrl if it is not nullptr, and ctrl::Cancelled is thrown when it is aborted.
+	/// </summary>
+	/// <param name="num_qubits"></param>
+	/// <param name="ops">the gates in the order of application</param>
+	/// <param name="state"></param>
+	/// <param name="p_ctrl"></param>
+	/// <returns></returns>
+	template <class W>
+	tdd::TDD<W> simulate(int num_qubits, const std::vector<operation<W>>& ops, bool state = false, ctrl::Controller* p_ctrl = nullptr) {
+		static_assert(!std::is_same_v<W, CUDAcpl::Tensor>, "the circuit simulation is for scalar weights only.");
+
+		// check the operations before the construction
+		for (int i = 0; i < ops.size(); i++) {
+			auto&& qubits = ops[i].qubits;
+			for (int j = 0; j < qubits.size(); j++) {
+				if (qubits[j] < 0 || qubits[j] >= num_qubits ||
+					std::find(qubits.begin(), qubits.begin() + j, qubits[j]) != qubits.begin() + j) {
+					throw std::invalid_argument("invalid qubits of gate " + std::to_string(i) + ".");
+				}
+			}
+			if (qubits.empty() || ops[i].matrix.size() != ((int64_t)1 << (2 * qubits.size()))) {
+				throw std::invalid_argument("the matrix of gate " + std::to_string(i) + " does not match its qubits.");
+			}
+		}
+
+		ctrl::Scope scope{ p_ctrl };
+
+		auto&& res = state ? zero_state<W>(num_qubits) : gates::identity<W>(num_qubits);
+		for (auto&& op : ops) {
+			res = apply_gate(res, op);
+		}
+		return res;
+	}
+}
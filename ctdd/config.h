@@ -1,8 +1,16 @@
 #pragma once
 
+#ifdef SCALAR_WEIGHT_FLOAT
+// the single precision scalar weight, which halves the weight storage in nodes.
+// EPS is loosened accordingly, for the rounding error of float is about 6E-8 per operation.
+typedef std::complex<float> wcomplex;
+
+const double DEFAULT_EPS = 3E-5;
+#else
 typedef std::complex<double> wcomplex;
 
 const double DEFAULT_EPS = 3E-7;
+#endif
 
 const int DEFAULT_THREAD_NUM = 4;
 
@@ -12,6 +20,30 @@ const uint64_t DEFAULT_VMEM_LIMIT = 8 * 1024. * 1024. * 1024.;
 
 const double DEFAULT_MEM_CHECK_PERIOD = 0.5;
 
+// the default period (in second) to report the progress of a controlled operation
+const double DEFAULT_PROGRESS_PERIOD = 0.5;
+
+// the estimated time (in second) of one contraction step, and the extra time for each parallel element
+const double DEFAULT_CONT_STEP_TIME = 2E-6;
+const double DEFAULT_CONT_ELEMENT_TIME = 2E-9;
+
+// the maximum size growth (ratio) allowed when moving an index during sifting
+const double DEFAULT_SIFT_MAX_GROWTH = 1.2;
+
+// the total level number of two operands, beyond which the contraction is conducted with the explicit frame stack
+// on the calling thread instead of the recursive parallel iteration. 0 for always.
+const int DEFAULT_STACK_CONT_DEPTH = 512;
+
+// the maximum estimated node number of one slice result in the hybrid Schrodinger-Feynman contraction
+const double DEFAULT_HSF_SLICE_BUDGET = 1E6;
+
+// the distance to the bucket boundary (in fraction of a bucket, i.e. of EPS), within which the adjacent bucket is also probed
+// when a scalar-weight node is looked up in the unique table. It covers the noise accumulated in the weights, far below EPS.
+const double DEFAULT_PROBE_MARGIN = 0.02;
+
+// the maximum number of weight codes probed in the adjacent buckets (2^n - 1 extra lookups at most)
+const int MAX_PROBE_CODES = 4;
+
 // the info line num in /proc/{pid}/status file
 #define VMRSS_LINE 22
 
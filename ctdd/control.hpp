@@ -0,0 +1,347 @@
+#pragma once
+#include "stdafx.h"
+
+namespace ctrl {
+
+	/// <summary>
+	/// The reasons for an operation to be aborted.
+	/// </summary>
+	enum class Abort : int {
+		NONE = 0,
+		USER = 1,
+		TIME_LIMIT = 2,
+		NODE_LIMIT = 3,
+		CALLBACK = 4
+	};
+
+	/// <summary>
+	/// The exception thrown out of the calculation when the running operation is aborted.
+	/// Note that the caches stay consistent, for only the completed results are recorded.
+	/// </summary>
+	class Cancelled : public std::runtime_error {
+	private:
+		Abort m_reason;
+
+	public:
+		Cancelled(Abort reason, const char* msg) : std::runtime_error(msg), m_reason(reason) {}
+
+		inline Abort reason() const noexcept {
+			return m_reason;
+		}
+	};
+
+	/// <summary>
+	/// The progress of the running operation.
+	/// </summary>
+	struct Progress {
+		int64_t nodes_created;
+		int64_t cache_hits;
+		double elapsed;
+	};
+
+	/// <summary>
+	/// The number of checks between two examinations of the clock (must be a power of 2).
+	/// </summary>
+	constexpr uint32_t CHECK_MASK = 0xFF;
+
+	/// <summary>
+	/// The controller of one (long-running) operation. It works as the cancellation token, and supervises
+	/// the wall-clock and node-count limits. The progress callback is always invoked on the thread
+	/// which starts the operation, and the operation is cancelled if it returns false.
+	/// </summary>
+	class Controller {
+	private:
+		std::atomic<bool> m_cancelled;
+		std::atomic<int> m_reason;
+
+		// 0 for no limit
+		std::chrono::duration<double> m_time_limit;
+		// 0 for no limit
+		int64_t m_node_limit;
+
+		std::chrono::duration<double> m_report_period;
+		std::function<bool(const Progress&)> m_callback;
+
+		// the approximation settings. 0 for exact calculation.
+		double m_approx_threshold;
+		int64_t m_level_budget;
+
+		// the node number beyond which contraction results are reordered by sifting. 0 for never.
+		int64_t m_sift_threshold;
+
+		// the fidelity accumulated over the approximated operations
+		std::atomic<double> m_fidelity;
+
+		std::atomic<int64_t> m_nodes_created;
+		std::atomic<int64_t> m_cache_hits;
+		std::atomic<uint32_t> m_check_count;
+
+		std::chrono::steady_clock::time_point m_start;
+		std::chrono::steady_clock::time_point m_last_report;
+		std::thread::id m_owner;
+
+	private:
+
+		inline void abort(Abort reason) noexcept {
+			int none = (int)Abort::NONE;
+			m_reason.compare_exchange_strong(none, (int)reason);
+			m_cancelled.store(true);
+		}
+
+		[[noreturn]] void throw_cancelled() const {
+			auto reason = (Abort)m_reason.load();
+			switch (reason) {
+			case Abort::TIME_LIMIT:
+				throw Cancelled(reason, "the operation exceeds the time limit.");
+			case Abort::NODE_LIMIT:
+				throw Cancelled(reason, "the operation exceeds the node limit.");
+			case Abort::CALLBACK:
+				throw Cancelled(reason, "the operation is cancelled by the progress callback.");
+			default:
+				throw Cancelled(Abort::USER, "the operation is cancelled.");
+			}
+		}
+
+	public:
+
+		Controller(double time_limit = 0., int64_t node_limit = 0, double report_period = DEFAULT_PROGRESS_PERIOD,
+			std::function<bool(const Progress&)>&& callback = nullptr) noexcept :
+			m_cancelled(false), m_reason((int)Abort::NONE),
+			m_time_limit(time_limit), m_node_limit(node_limit),
+			m_report_period(report_period), m_callback(std::move(callback)),
+			m_approx_threshold(0.), m_level_budget(0), m_sift_threshold(0), m_fidelity(1.),
+			m_nodes_created(0), m_cache_hits(0), m_check_count(0) {
+			m_start = std::chrono::steady_clock::now();
+			m_last_report = m_start;
+			m_owner = std::this_thread::get_id();
+		}
+
+		/// <summary>
+		/// Prepare for a new operation started on the current thread.
+		/// The counters and clock are reset, while a cancellation by the user remains valid.
+		/// </summary>
+		void start() noexcept {
+			if (m_reason.load() != (int)Abort::USER) {
+				m_reason.store((int)Abort::NONE);
+				m_cancelled.store(false);
+			}
+			m_nodes_created.store(0);
+			m_cache_hits.store(0);
+			m_check_count.store(0);
+			m_start = std::chrono::steady_clock::now();
+			m_last_report = m_start;
+			m_owner = std::this_thread::get_id();
+		}
+
+		inline void set_callback(std::function<bool(const Progress&)>&& callback) noexcept {
+			m_callback = std::move(callback);
+		}
+
+		/// <summary>
+		/// Enable the approximation of the supervised contractions. Nodes contributing less than threshold
+		/// (in fraction of the squared norm) are pruned, and at most level_budget nodes are kept at each level.
+		/// The pruning takes place while the results are contracted, so that it limits the time and the memory as well.
+		/// 0 for no pruning and no budget respectively. Only the scalar weight supports approximation.
+		/// </summary>
+		inline void set_approximation(double threshold, int64_t level_budget) noexcept {
+			m_approx_threshold = threshold;
+			m_level_budget = level_budget;
+		}
+
+		inline bool is_approximating() const noexcept {
+			return m_approx_threshold > 0 || m_level_budget > 0;
+		}
+
+		inline double approx_threshold() const noexcept {
+			return m_approx_threshold;
+		}
+
+		inline int64_t level_budget() const noexcept {
+			return m_level_budget;
+		}
+
+		/// <summary>
+		/// Reorder the results of the supervised contractions by sifting, if they have more nodes than threshold.
+		/// 0 for never. Note that the storage order of such results differs from the usual one.
+		/// </summary>
+		inline void set_sift_threshold(int64_t threshold) noexcept {
+			m_sift_threshold = threshold;
+		}
+
+		inline int64_t sift_threshold() const noexcept {
+			return m_sift_threshold;
+		}
+
+		/// <summary>
+		/// Record the loss (in fraction of the squared norm) of one approximation.
+		/// </summary>
+		inline void record_loss(double loss) noexcept {
+			m_fidelity.store(m_fidelity.load() * (1. - loss));
+		}
+
+		/// <summary>
+		/// The fidelity between the (normalized) approximated and exact results, accumulated over the operations.
+		/// Note that it is an estimate, for the exact results are never calculated.
+		/// </summary>
+		inline double fidelity() const noexcept {
+			return m_fidelity.load();
+		}
+
+		/// <summary>
+		/// Clear the cancellation by the user and the accumulated fidelity, so that this controller can be reused.
+		/// </summary>
+		inline void reset() noexcept {
+			m_reason.store((int)Abort::NONE);
+			m_cancelled.store(false);
+			m_fidelity.store(1.);
+		}
+
+		/// <summary>
+		/// thread safety: it can be called from any thread.
+		/// </summary>
+		inline void cancel() noexcept {
+			abort(Abort::USER);
+		}
+
+		inline bool is_cancelled() const noexcept {
+			return m_cancelled.load();
+		}
+
+		inline Abort reason() const noexcept {
+			return (Abort)m_reason.load();
+		}
+
+		inline void count_node() noexcept {
+			m_nodes_created.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		inline void count_hit() noexcept {
+			m_cache_hits.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		inline Progress progress() const noexcept {
+			return Progress{
+				m_nodes_created.load(std::memory_order_relaxed),
+				m_cache_hits.load(std::memory_order_relaxed),
+				std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count()
+			};
+		}
+
+		/// <summary>
+		/// Examine the limits and invoke the callback if it is due (only on the owner thread). It never throws.
+		/// </summary>
+		void poll() {
+			if (m_cancelled.load(std::memory_order_relaxed)) {
+				return;
+			}
+			auto&& now = std::chrono::steady_clock::now();
+			if (m_time_limit.count() > 0 && now - m_start > m_time_limit) {
+				abort(Abort::TIME_LIMIT);
+				return;
+			}
+			if (m_callback && std::this_thread::get_id() == m_owner && now - m_last_report >= m_report_period) {
+				m_last_report = now;
+				if (!m_callback(progress())) {
+					abort(Abort::CALLBACK);
+				}
+			}
+		}
+
+		/// <summary>
+		/// The check inserted in the iterations. Throw ctrl::Cancelled if the operation should stop.
+		/// </summary>
+		inline void check() {
+			if (m_node_limit > 0 && m_nodes_created.load(std::memory_order_relaxed) > m_node_limit) {
+				abort(Abort::NODE_LIMIT);
+			}
+			// the clock is examined once every (CHECK_MASK + 1) checks
+			if ((m_check_count.fetch_add(1, std::memory_order_relaxed) & CHECK_MASK) == 0) {
+				poll();
+			}
+			if (m_cancelled.load(std::memory_order_relaxed)) {
+				throw_cancelled();
+			}
+		}
+	};
+
+
+	/// <summary>
+	/// The controller of the operation running on this thread. nullptr for no control.
+	/// Each thread has its own, so that operations on different threads are supervised separately,
+	/// and the tasks sent to the thread pool take the controller of the caller with ctrl::bind.
+	/// </summary>
+	extern thread_local Controller* p_current;
+
+	inline Controller* current() noexcept {
+		return p_current;
+	}
+
+	inline void check() {
+		if (p_current) {
+			p_current->check();
+		}
+	}
+
+	inline void poll() {
+		if (p_current) {
+			p_current->poll();
+		}
+	}
+
+	inline void count_node() noexcept {
+		if (p_current) {
+			p_current->count_node();
+		}
+	}
+
+	inline void count_hit() noexcept {
+		if (p_current) {
+			p_current->count_hit();
+		}
+	}
+
+	/// <summary>
+	/// Install the controller for the lifetime of this object. Nothing happens if nullptr is given,
+	/// so that inner operations are supervised by the outer controller.
+	/// </summary>
+	class Scope {
+	private:
+		Controller* m_prev;
+		bool m_active;
+
+	public:
+		explicit Scope(Controller* p_ctrl) noexcept : m_prev(nullptr), m_active(p_ctrl != nullptr) {
+			if (m_active) {
+				p_ctrl->start();
+				m_prev = p_current;
+				p_current = p_ctrl;
+			}
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator = (const Scope&) = delete;
+
+		~Scope() noexcept {
+			if (m_active) {
+				p_current = m_prev;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Wrap the task, so that it runs under the controller of the calling thread (without restarting it)
+	/// when it is executed in the thread pool.
+	/// </summary>
+	template <class F>
+	inline auto bind(F&& f) {
+		return [p_ctrl = p_current, f = std::forward<F>(f)]() mutable {
+			auto p_prev = p_current;
+			p_current = p_ctrl;
+			struct Restore {
+				Controller* p_prev;
+				~Restore() { p_current = p_prev; }
+			} restore{ p_prev };
+			return f();
+		};
+	}
+}
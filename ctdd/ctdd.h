@@ -6,7 +6,11 @@
 namespace Ctdd {
 
 	// two data types
+#ifdef SCALAR_WEIGHT_FLOAT
+	typedef std::complex<float> wcomplex;
+#else
 	typedef std::complex<double> wcomplex;
+#endif
 	typedef torch::Tensor Tensor;
 
 
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "tdd.hpp"
 #include "wnode.hpp"
+#include "circuit.hpp"
+#include "async.hpp"
 #include "manage.hpp"
 
 using namespace std;
@@ -9,6 +11,131 @@ using namespace tdd;
 using namespace mng;
 
 
+// the python exception raised when a controlled operation is aborted
+static PyObject* CancelledError = nullptr;
+
+/// <summary>
+/// The controller used through the python interface, which holds the progress callback.
+/// </summary>
+struct PyController : public ctrl::Controller {
+	PyObject* p_callback;
+
+	PyController(double time_limit, int64_t node_limit, double report_period, PyObject* _p_callback) :
+		ctrl::Controller(time_limit, node_limit, report_period), p_callback(_p_callback) {
+		Py_XINCREF(p_callback);
+	}
+
+	~PyController() {
+		Py_XDECREF(p_callback);
+	}
+};
+
+/// <summary>
+/// The scope of a heavy C++ section, in which the GIL is released and the engine lock (mng::engine_mutex) is held.
+/// It works as Py_BEGIN_ALLOW_THREADS and Py_END_ALLOW_THREADS, and also takes the GIL back when an exception is thrown.
+/// The GIL is released before waiting for the engine, so that a waiting caller never blocks the other python threads
+/// (including the progress callback of the running operation). No python API should be called in this scope.
+/// </summary>
+struct EngineScope {
+	PyThreadState* p_thread_state;
+	std::unique_lock<std::recursive_mutex> lock;
+
+	EngineScope() : p_thread_state(PyEval_SaveThread()), lock(mng::engine_mutex) {}
+
+	~EngineScope() {
+		lock.unlock();
+		PyEval_RestoreThread(p_thread_state);
+	}
+};
+
+/// <summary>
+/// Set the python exception for the aborted operation, and return NULL.
+/// Note that the exception raised in the progress callback is kept.
+/// </summary>
+/// <param name="e"></param>
+/// <returns></returns>
+static PyObject*
+set_cancelled(const ctrl::Cancelled& e) {
+	if (!PyErr_Occurred()) {
+		PyErr_SetString(CancelledError, e.what());
+	}
+	return NULL;
+}
+
+/// <summary>
+/// Set the python exception for the exception being handled, and return NULL. It should be called in the catch (...)
+/// clause after an EngineScope section (with the GIL held again): the cancellation raises CancelledError,
+/// std::invalid_argument and std::domain_error raise ValueError, and the other exceptions raise RuntimeError.
+/// </summary>
+/// <returns></returns>
+static PyObject*
+set_engine_error() {
+	try {
+		throw;
+	}
+	catch (const ctrl::Cancelled& e) {
+		return set_cancelled(e);
+	}
+	catch (const std::invalid_argument& e) {
+		PyErr_SetString(PyExc_ValueError, e.what());
+	}
+	catch (const std::domain_error& e) {
+		PyErr_SetString(PyExc_ValueError, e.what());
+	}
+	catch (const std::exception& e) {
+		PyErr_SetString(PyExc_RuntimeError, e.what());
+	}
+	catch (...) {
+		PyErr_SetString(PyExc_RuntimeError, "unknown error in the tdd engine.");
+	}
+	return NULL;
+}
+
+/// <summary>
+/// Submit the operation f (returning TDD<W>) to the dispatcher thread (async_ops), and return None immediately.
+/// On completion, done(pointer, tensor_weight, error, message) is called with the GIL held, where error is 0 for success,
+/// 1 for the cancellation and 2 for other failures. The operands should be kept alive by the caller until then.
+/// Note that the exception raised in the progress callback is not kept, and the operation is cancelled.
+/// </summary>
+/// <param name="p_done">the python callable</param>
+/// <param name="f"></param>
+/// <returns></returns>
+template <class W, class F>
+static PyObject*
+submit_operation(PyObject* p_done, F&& f) {
+	Py_INCREF(p_done);
+	async_ops::submit<W>(std::forward<F>(f), [p_done](std::unique_ptr<TDD<W>>&& p_res, std::exception_ptr p_error) {
+		int error = 0;
+		std::string message;
+		if (p_error) {
+			try {
+				std::rethrow_exception(p_error);
+			}
+			catch (const ctrl::Cancelled& e) {
+				error = 1;
+				message = e.what();
+			}
+			catch (const std::exception& e) {
+				error = 2;
+				message = e.what();
+			}
+		}
+		auto&& gil_state = PyGILState_Ensure();
+		auto&& p_tensor_weight = std::is_same_v<W, CUDAcpl::Tensor> ? Py_True : Py_False;
+		auto&& p_ret = PyObject_CallFunction(p_done, "LOis", (int64_t)p_res.release(), p_tensor_weight, error, message.c_str());
+		if (p_ret == NULL) {
+			PyErr_WriteUnraisable(p_done);
+		}
+		else {
+			Py_DECREF(p_ret);
+		}
+		Py_DECREF(p_done);
+		PyGILState_Release(gil_state);
+		});
+	return Py_BuildValue("");
+}
+
+
 /// <summary>
 /// this method is for testing purpose
 /// </summary>
@@ -32,44 +159,37 @@ test(PyObject* self, PyObject* args) {
 static PyObject*
 get_config(PyObject* self, PyObject* args) {
 
-	int thread_num = wnode::iter_para::p_thread_pool->thread_num();
+	int thread_num;
+	try {
+		EngineScope scope;
+		thread_num = wnode::iter_para::p_thread_pool->thread_num();
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 	bool device_cuda = CUDAcpl::tensor_opt.device_opt() == c10::DeviceType::CUDA;
 	bool double_type = CUDAcpl::tensor_opt.dtype_opt() == c10::ScalarType::Double;
 	double eps = weight::EPS;
 	double gc_check_period = mng::garbage_check_period.load().count();
 	double vmem_limit_MB = mng::vmem_limit / 1024. / 1024.;
+	int stack_cont_depth = mng::stack_cont_depth.load();
+	bool scalar_double = std::is_same_v<wcomplex::value_type, double>;
+	double default_eps = DEFAULT_EPS;
 
-	return Py_BuildValue("{sisbsbsdsdsd}",
+	return Py_BuildValue("{sisbsbsbsdsdsdsdsi}",
 		"thread num", thread_num,
 		"device cuda", device_cuda,
 		"dtype double", double_type,
+		"scalar double", scalar_double,
 		"EPS", eps,
+		"default EPS", default_eps,
 		"gc check period", gc_check_period,
-		"vmem limit", vmem_limit_MB);
+		"vmem limit", vmem_limit_MB,
+		"stack cont depth", stack_cont_depth);
 }
 
 
 
-/// <summary>
-/// delete the tdd passed in (garbage collection)
-/// </summary>
-/// <typeparam name="W"></typeparam>
-/// <param name="self"></param>
-/// <param name="args"></param>
-/// <returns></returns>
-template <class W>
-static PyObject*
-delete_tdd(PyObject* self, PyObject* args) {
-	//convert from long long
-	int64_t code;
-	if (!PyArg_ParseTuple(args, "L", &code)) {
-		return NULL;
-	}
-	TDD<W>* p_tdd = (TDD<W>*)code;
-	delete p_tdd;
-	return Py_BuildValue("");
-}
-
 /// <summary>
 /// clear the garbage only
 /// </summary>
@@ -78,7 +198,13 @@ delete_tdd(PyObject* self, PyObject* args) {
 /// <returns></returns>
 static PyObject*
 clear_garbage(PyObject* self, PyObject* args) {
-	clear_garbage();
+	try {
+		EngineScope scope;
+		clear_garbage();
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 	return Py_BuildValue("");
 }
 
@@ -90,8 +216,14 @@ clear_garbage(PyObject* self, PyObject* args) {
 /// <returns></returns>
 static PyObject*
 clear_cache(PyObject* self, PyObject* args) {
-	clear_garbage();
-	clear_cache();
+	try {
+		EngineScope scope;
+		clear_garbage();
+		clear_cache();
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 	return Py_BuildValue("");
 }
 
@@ -113,11 +245,155 @@ reset(PyObject* self, PyObject* args) {
 		return NULL;
 
 	// note that the settings here are shared between scalar and tensor weight.
-	reset(thread_num, device_cuda, double_type, new_eps, gc_check_period, vmem_limit_MB);
+	try {
+		EngineScope scope;
+		reset(thread_num, device_cuda, double_type, new_eps, gc_check_period, vmem_limit_MB);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	return Py_BuildValue("");
 }
 
+/// <summary>
+/// set the total level number of two operands, beyond which the contraction is conducted with the explicit frame stack.
+/// 0 for always.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+static PyObject*
+set_stack_cont_depth(PyObject* self, PyObject* args) {
+	int depth;
+	if (!PyArg_ParseTuple(args, "i", &depth))
+		return NULL;
+
+	mng::stack_cont_depth.store(depth);
+
+	return Py_BuildValue("");
+}
+
+
+
+/// <summary>
+/// Create a controller and return the pointer.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">(time_limit, node_limit, report_period, callback, approx_threshold, level_budget, sift_threshold).
+/// 0 for no limit, and None for no callback.
+/// The callback is called with (nodes_created, cache_hits, elapsed), and the operation is cancelled if it returns False.
+/// Contraction results are approximated if approx_threshold or level_budget is not 0,
+/// and reordered by sifting if they have more nodes than sift_threshold (not 0).</param>
+/// <returns></returns>
+static PyObject*
+controller_new(PyObject* self, PyObject* args) {
+	double time_limit, report_period, approx_threshold = 0.;
+	int64_t node_limit, level_budget = 0, sift_threshold = 0;
+	PyObject* p_callback;
+	if (!PyArg_ParseTuple(args, "dLdO|dLL", &time_limit, &node_limit, &report_period, &p_callback,
+		&approx_threshold, &level_budget, &sift_threshold)) {
+		return NULL;
+	}
+	if (p_callback == Py_None) {
+		p_callback = nullptr;
+	}
+
+	auto&& p_res = new PyController(time_limit, node_limit, report_period, p_callback);
+	p_res->set_approximation(approx_threshold, level_budget);
+	p_res->set_sift_threshold(sift_threshold);
+	if (p_callback) {
+		// the callback is only invoked on the thread which starts the operation,
+		// and the GIL (released during the operation) is taken back for the call
+		p_res->set_callback([p_callback](const ctrl::Progress& progress) {
+			auto&& gil_state = PyGILState_Ensure();
+			auto&& p_ret = PyObject_CallFunction(p_callback, "LLd",
+				progress.nodes_created, progress.cache_hits, progress.elapsed);
+			bool go_on = false;
+			// otherwise the python exception is kept and will be raised afterwards
+			if (p_ret != NULL) {
+				go_on = p_ret != Py_False;
+				Py_DECREF(p_ret);
+			}
+			PyGILState_Release(gil_state);
+			return go_on;
+			});
+	}
+
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
+}
+
+/// <summary>
+/// Cancel the operation supervised by the controller.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+static PyObject*
+controller_cancel(PyObject* self, PyObject* args) {
+	int64_t code;
+	if (!PyArg_ParseTuple(args, "L", &code)) {
+		return NULL;
+	}
+	((PyController*)code)->cancel();
+	return Py_BuildValue("");
+}
+
+/// <summary>
+/// Clear the cancellation, so that the controller can be reused.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+static PyObject*
+controller_reset(PyObject* self, PyObject* args) {
+	int64_t code;
+	if (!PyArg_ParseTuple(args, "L", &code)) {
+		return NULL;
+	}
+	((PyController*)code)->reset();
+	return Py_BuildValue("");
+}
+
+/// <summary>
+/// Return the progress of the (last) operation supervised by the controller in a dictionary.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+static PyObject*
+controller_progress(PyObject* self, PyObject* args) {
+	int64_t code;
+	if (!PyArg_ParseTuple(args, "L", &code)) {
+		return NULL;
+	}
+	auto p_ctrl = (PyController*)code;
+	auto&& progress = p_ctrl->progress();
+	return Py_BuildValue("{sLsLsdsbsisd}",
+		"nodes created", progress.nodes_created,
+		"cache hits", progress.cache_hits,
+		"elapsed", progress.elapsed,
+		"cancelled", p_ctrl->is_cancelled(),
+		"reason", (int)p_ctrl->reason(),
+		"fidelity", p_ctrl->fidelity());
+}
+
+/// <summary>
+/// delete the controller passed in
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+static PyObject*
+controller_delete(PyObject* self, PyObject* args) {
+	int64_t code;
+	if (!PyArg_ParseTuple(args, "L", &code)) {
+		return NULL;
+	}
+	delete (PyController*)code;
+	return Py_BuildValue("");
+}
 
 
 
@@ -125,15 +401,18 @@ reset(PyObject* self, PyObject* args) {
 /// Take in the CUDAcpl tensor, transform to TDD and returns the pointer.
 /// </summary>
 /// <param name="self"></param>
-/// <param name="args">for storage_order, put in [] from python to indicate the trival order.</param>
-/// <returns>the pointer to the tdd</returns>
+/// <param name="args">for storage_order, put in [] from python to indicate the trival order.
+/// The pointer to the controller and the completion callable (for the asynchronous execution) can be put in optionally.</param>
+/// <returns>the pointer to the tdd (None if it is asynchronous)</returns>
 template <class W>
 static PyObject*
 as_tensor(PyObject* self, PyObject* args)
 {
 	PyObject* p_tensor, * p_storage_order_ls;
 	int dim_parallel;
-	if (!PyArg_ParseTuple(args, "OiO", &p_tensor, &dim_parallel, &p_storage_order_ls))
+	int64_t ctrl_code = 0;
+	PyObject* p_done = Py_None;
+	if (!PyArg_ParseTuple(args, "OiO|LO", &p_tensor, &dim_parallel, &p_storage_order_ls, &ctrl_code, &p_done))
 		return NULL;
 	auto&& t = THPVariable_Unpack(p_tensor);
 
@@ -144,8 +423,225 @@ as_tensor(PyObject* self, PyObject* args)
 		storage_order[i] = PyLong_AsLongLong(PyList_GetItem(p_storage_order_ls, i));
 	}
 
+	if (p_done != Py_None) {
+		return submit_operation<W>(p_done, [t, dim_parallel, storage_order, ctrl_code]() {
+			return TDD<W>::as_tensor(t, dim_parallel, storage_order, (PyController*)ctrl_code);
+			});
+	}
+
 	//construct the tdd
-	auto&& p_res = new TDD<W>(TDD<W>::as_tensor(t, dim_parallel, storage_order));
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(TDD<W>::as_tensor(t, dim_parallel, storage_order, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	// convert to long long
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
+}
+
+/// <summary>
+/// Check that the buffer can be addressed as doubles in place, i.e. it is aligned to double and its strides are
+/// non-negative multiples of sizeof(double). Otherwise set ValueError and return false.
+/// </summary>
+/// <param name="view"></param>
+/// <returns></returns>
+static bool
+check_buffer_layout(const Py_buffer& view) {
+	if ((uintptr_t)view.buf % alignof(double) != 0) {
+		PyErr_SetString(PyExc_ValueError, "the buffer is not aligned to double.");
+		return false;
+	}
+	for (int i = 0; i < view.ndim; i++) {
+		if (view.strides[i] < 0 || view.strides[i] % (Py_ssize_t)sizeof(double) != 0) {
+			PyErr_SetString(PyExc_ValueError, "the buffer strides should be non-negative multiples of sizeof(double).");
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Take in the object of the complex128 buffer (e.g. a numpy array), transform to TDD and returns the pointer.
+/// The buffer is read in place, without any intermediate copy.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">for storage_order, put in [] from python to indicate the trival order.
+/// The pointer to the controller can be put in optionally.</param>
+/// <returns>the pointer to the tdd</returns>
+static PyObject*
+as_buffer(PyObject* self, PyObject* args)
+{
+	PyObject* p_obj, * p_storage_order_ls;
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "OO|L", &p_obj, &p_storage_order_ls, &ctrl_code))
+		return NULL;
+
+	Py_buffer view;
+	if (PyObject_GetBuffer(p_obj, &view, PyBUF_STRIDES | PyBUF_FORMAT) != 0) {
+		return NULL;
+	}
+	if (view.format == nullptr || std::string(view.format) != "Zd" || view.itemsize != 2 * sizeof(double)) {
+		PyBuffer_Release(&view);
+		PyErr_SetString(PyExc_ValueError, "the buffer should be of complex128.");
+		return NULL;
+	}
+	if (!check_buffer_layout(view)) {
+		PyBuffer_Release(&view);
+		return NULL;
+	}
+
+	// the real view of the buffer, in the CUDAcpl form
+	std::vector<int64_t> shape(view.shape, view.shape + view.ndim);
+	shape.push_back(2);
+	std::vector<int64_t> strides(view.ndim + 1);
+	for (int i = 0; i < view.ndim; i++) {
+		strides[i] = view.strides[i] / (Py_ssize_t)sizeof(double);
+	}
+	strides[view.ndim] = 1;
+	auto&& t = torch::from_blob(view.buf, shape, strides, c10::TensorOptions().dtype(c10::ScalarType::Double));
+
+	auto&& size = PyList_GET_SIZE(p_storage_order_ls);
+	std::vector<int64_t> storage_order(size);
+	for (int i = 0; i < size; i++) {
+		storage_order[i] = PyLong_AsLongLong(PyList_GetItem(p_storage_order_ls, i));
+	}
+
+	//construct the tdd
+	TDD<wcomplex>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<wcomplex>(TDD<wcomplex>::as_tensor(t, 0, storage_order, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		PyBuffer_Release(&view);
+		return set_engine_error();
+	}
+	PyBuffer_Release(&view);
+	// convert to long long
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
+}
+
+/// <summary>
+/// Take in the sparse tensor in the COO format, transform to TDD and returns the pointer.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">the coordinates (int64 tensor of shape (nnz, dim_data)), the values (CUDAcpl tensor of shape (nnz, 2)),
+/// the data shape list and the storage order list ([] for the trival order).
+/// The pointer to the controller can be put in optionally.</param>
+/// <returns>the pointer to the tdd</returns>
+static PyObject*
+as_sparse(PyObject* self, PyObject* args)
+{
+	PyObject* p_indices, * p_values, * p_data_shape_ls, * p_storage_order_ls;
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "OOOO|L", &p_indices, &p_values, &p_data_shape_ls, &p_storage_order_ls, &ctrl_code))
+		return NULL;
+
+	// read the buffers on cpu
+	auto&& t_indices = THPVariable_Unpack(p_indices).cpu().to(c10::ScalarType::Long).contiguous();
+	auto&& t_values = THPVariable_Unpack(p_values).cpu().to(c10::ScalarType::Double).contiguous();
+	auto p_index_data = t_indices.data_ptr<int64_t>();
+	std::vector<int64_t> indices(p_index_data, p_index_data + t_indices.numel());
+	auto p_value_data = t_values.data_ptr<double>();
+	std::vector<wcomplex> values(t_values.numel() / 2);
+	for (int64_t i = 0; i < values.size(); i++) {
+		values[i] = wcomplex(p_value_data[2 * i], p_value_data[2 * i + 1]);
+	}
+
+	auto&& size = PyList_GET_SIZE(p_data_shape_ls);
+	std::vector<int64_t> data_shape(size);
+	for (int i = 0; i < size; i++) {
+		data_shape[i] = PyLong_AsLongLong(PyList_GetItem(p_data_shape_ls, i));
+	}
+	size = PyList_GET_SIZE(p_storage_order_ls);
+	std::vector<int64_t> storage_order(size);
+	for (int i = 0; i < size; i++) {
+		storage_order[i] = PyLong_AsLongLong(PyList_GetItem(p_storage_order_ls, i));
+	}
+
+	//construct the tdd
+	TDD<wcomplex>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<wcomplex>(TDD<wcomplex>::as_sparse(indices, values, data_shape, storage_order, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	// convert to long long
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
+}
+
+/// <summary>
+/// Simulate the whole circuit in C++, and return the pointer to the tdd of the unitary (or the state from |0...0>).
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">the number of qubits, the list of gates and whether to simulate the state.
+/// A gate is a tuple (name or CUDAcpl matrix, qubit list, parameter list).
+/// The pointer to the controller can be put in optionally.</param>
+/// <returns>the pointer to the tdd</returns>
+static PyObject*
+circuit_tdd(PyObject* self, PyObject* args)
+{
+	int num_qubits;
+	PyObject* p_gates_ls;
+	int state;
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "iOp|L", &num_qubits, &p_gates_ls, &state, &ctrl_code))
+		return NULL;
+
+	auto&& num_gates = PyList_GET_SIZE(p_gates_ls);
+	std::vector<circuit::operation<wcomplex>> ops(num_gates);
+	try {
+		for (int i = 0; i < num_gates; i++) {
+			auto&& p_gate = PyList_GetItem(p_gates_ls, i);
+			auto&& p_matrix = PyTuple_GetItem(p_gate, 0);
+			auto&& p_qubits_ls = PyTuple_GetItem(p_gate, 1);
+			auto&& p_params_ls = PyTuple_GetItem(p_gate, 2);
+
+			auto&& size = PyList_GET_SIZE(p_qubits_ls);
+			ops[i].qubits.resize(size);
+			for (int j = 0; j < size; j++) {
+				ops[i].qubits[j] = PyLong_AsLongLong(PyList_GetItem(p_qubits_ls, j));
+			}
+			if (PyUnicode_Check(p_matrix)) {
+				size = PyList_GET_SIZE(p_params_ls);
+				std::vector<double> params(size);
+				for (int j = 0; j < size; j++) {
+					params[j] = PyFloat_AsDouble(PyList_GetItem(p_params_ls, j));
+				}
+				ops[i].matrix = circuit::named_matrix(PyUnicode_AsUTF8(p_matrix), params);
+			}
+			else {
+				auto&& t = THPVariable_Unpack(p_matrix).cpu().to(c10::ScalarType::Double).contiguous();
+				auto p_data = t.data_ptr<double>();
+				ops[i].matrix.resize(t.numel() / 2);
+				for (int64_t j = 0; j < ops[i].matrix.size(); j++) {
+					ops[i].matrix[j] = wcomplex(p_data[2 * j], p_data[2 * j + 1]);
+				}
+			}
+		}
+	}
+	catch (const std::invalid_argument& e) {
+		PyErr_SetString(PyExc_ValueError, e.what());
+		return NULL;
+	}
+
+	//construct the tdd
+	TDD<wcomplex>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<wcomplex>(circuit::simulate<wcomplex>(num_qubits, ops, state, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 	// convert to long long
 	int64_t code = (int64_t)p_res;
 	return Py_BuildValue("L", code);
@@ -168,7 +664,14 @@ as_tensor_clone(PyObject* self, PyObject* args)
 	TDD<W>* p_tdd = (TDD<W>*)code;
 
 	//construct the tdd
-	auto&& p_res = new TDD<W>(*p_tdd);
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(*p_tdd);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
 	int64_t res_code = (int64_t)p_res;
@@ -192,28 +695,383 @@ to_CUDAcpl(PyObject* self, PyObject* args) {
 	}
 	TDD<W>* p_tdd = (TDD<W>*)code;
 
-	auto&& tensor = p_tdd->CUDAcpl();
+	CUDAcpl::Tensor tensor;
+	try {
+		EngineScope scope;
+		tensor = p_tdd->CUDAcpl();
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 	return THPVariable_Wrap(tensor);
 }
 
-/// <summary>
-/// Return the sum of the two tdds.
-/// </summary>
-/// <param name="self"></param>
-/// <param name="args"></param>
-/// <returns></returns>
-template <typename W>
-static PyObject*
-sum(PyObject* self, PyObject* args) {
-	int64_t code_a, code_b;
-	if (!PyArg_ParseTuple(args, "LL", &code_a, &code_b)) {
-		return NULL;
+/// <summary>
+/// Write the tdd into the given python torch tensor directly.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">the pointer to the tdd and the output tensor (contiguous, of a floating type and of the shape of the tdd).</param>
+/// <returns></returns>
+template <class W>
+static PyObject*
+to_CUDAcpl_into(PyObject* self, PyObject* args) {
+
+	int64_t code;
+	PyObject* p_out;
+	if (!PyArg_ParseTuple(args, "LO", &code, &p_out)) {
+		return NULL;
+	}
+	TDD<W>* p_tdd = (TDD<W>*)code;
+	if (!THPVariable_Check(p_out)) {
+		PyErr_SetString(PyExc_ValueError, "the output should be a torch tensor.");
+		return NULL;
+	}
+	auto&& out = THPVariable_Unpack(p_out);
+
+	if (out.scalar_type() != c10::ScalarType::Double && out.scalar_type() != c10::ScalarType::Float) {
+		PyErr_SetString(PyExc_ValueError, "the output tensor should be of a floating type.");
+		return NULL;
+	}
+	std::vector<int64_t> shape(p_tdd->parallel_shape());
+	auto&& data_shape = p_tdd->data_shape();
+	shape.insert(shape.end(), data_shape.begin(), data_shape.end());
+	shape.push_back(2);
+	if (out.sizes() != c10::IntArrayRef(shape)) {
+		PyErr_SetString(PyExc_ValueError, "the output tensor is not of the shape of the tdd.");
+		return NULL;
+	}
+	if (!out.is_contiguous()) {
+		PyErr_SetString(PyExc_ValueError, "the output tensor should be contiguous.");
+		return NULL;
+	}
+
+	try {
+		EngineScope scope;
+		p_tdd->CUDAcpl_into(out);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	return Py_BuildValue("");
+}
+
+/// <summary>
+/// Write the tdd into the writable object of the complex128 buffer (e.g. a numpy array) directly.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">the pointer to the tdd and the output object (of the shape of the tdd).</param>
+/// <returns></returns>
+static PyObject*
+to_buffer(PyObject* self, PyObject* args) {
+
+	int64_t code;
+	PyObject* p_obj;
+	if (!PyArg_ParseTuple(args, "LO", &code, &p_obj)) {
+		return NULL;
+	}
+	TDD<wcomplex>* p_tdd = (TDD<wcomplex>*)code;
+
+	Py_buffer view;
+	if (PyObject_GetBuffer(p_obj, &view, PyBUF_STRIDES | PyBUF_FORMAT | PyBUF_WRITABLE) != 0) {
+		return NULL;
+	}
+	if (view.format == nullptr || std::string(view.format) != "Zd" || view.itemsize != 2 * sizeof(double)) {
+		PyBuffer_Release(&view);
+		PyErr_SetString(PyExc_ValueError, "the buffer should be of complex128.");
+		return NULL;
+	}
+	if (!check_buffer_layout(view)) {
+		PyBuffer_Release(&view);
+		return NULL;
+	}
+	auto&& data_shape = p_tdd->data_shape();
+	bool shape_match = view.ndim == p_tdd->dim_data();
+	for (int i = 0; shape_match && i < view.ndim; i++) {
+		shape_match = view.shape[i] == data_shape[i];
+	}
+	if (!shape_match) {
+		PyBuffer_Release(&view);
+		PyErr_SetString(PyExc_ValueError, "the buffer is not of the shape of the tdd.");
+		return NULL;
+	}
+
+	std::vector<int64_t> shape(view.shape, view.shape + view.ndim);
+	shape.push_back(2);
+	std::vector<int64_t> strides(view.ndim + 1);
+	for (int i = 0; i < view.ndim; i++) {
+		strides[i] = view.strides[i] / (Py_ssize_t)sizeof(double);
+	}
+	strides[view.ndim] = 1;
+
+	try {
+		EngineScope scope;
+		// zero-fill the buffer in place, for the zero sub-tensors are skipped
+		torch::from_blob(view.buf, shape, strides, c10::TensorOptions().dtype(c10::ScalarType::Double)).zero_();
+		p_tdd->write_buffer((double*)view.buf, strides);
+	}
+	catch (...) {
+		PyBuffer_Release(&view);
+		return set_engine_error();
+	}
+	PyBuffer_Release(&view);
+	return Py_BuildValue("");
+}
+
+/// <summary>
+/// Draw samples of the index values from the tdd, with the probability proportional to the squared magnitude.
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args">the pointer to the tdd, the number of samples and the seed.
+/// The pointer to the controller can be put in optionally.</param>
+/// <returns>the int64 torch tensor of shape (num_samples, dim_data)</returns>
+static PyObject*
+sample(PyObject* self, PyObject* args) {
+	int64_t code, num_samples;
+	uint64_t seed;
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "LLK|L", &code, &num_samples, &seed, &ctrl_code)) {
+		return NULL;
+	}
+	TDD<wcomplex>* p_tdd = (TDD<wcomplex>*)code;
+
+	std::vector<int64_t> samples;
+	try {
+		EngineScope scope;
+		samples = p_tdd->sample(num_samples, seed, (PyController*)ctrl_code);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	auto&& res = torch::empty({ num_samples, p_tdd->dim_data() }, c10::TensorOptions().dtype(c10::ScalarType::Long));
+	std::copy(samples.begin(), samples.end(), res.data_ptr<int64_t>());
+	return THPVariable_Wrap(res);
+}
+
+/// <summary>
+/// Return the sum of the two tdds.
+/// The completion callable can be put in after the controller, for the asynchronous execution (see submit_operation).
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <typename W>
+static PyObject*
+sum(PyObject* self, PyObject* args) {
+	int64_t code_a, code_b;
+	int64_t ctrl_code = 0;
+	PyObject* p_done = Py_None;
+	if (!PyArg_ParseTuple(args, "LL|LO", &code_a, &code_b, &ctrl_code, &p_done)) {
+		return NULL;
+	}
+	TDD<W>* p_tdda = (TDD<W>*)code_a;
+	TDD<W>* p_tddb = (TDD<W>*)code_b;
+
+	if (p_done != Py_None) {
+		return submit_operation<W>(p_done, [p_tdda, p_tddb, ctrl_code]() {
+			return TDD<W>::sum(*p_tdda, *p_tddb, (PyController*)ctrl_code);
+			});
+	}
+
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(TDD<W>::sum(*p_tdda, *p_tddb, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	// convert to long long
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
+}
+
+
+/// <summary>
+/// Trace the designated indices of the given tdd.
+/// The completion callable can be put in after the controller, for the asynchronous execution (see submit_operation).
+/// </summary>
+/// <typeparam name="W"></typeparam>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <class W>
+static PyObject*
+trace(PyObject* self, PyObject* args) {
+	int64_t code;
+	PyObject* p_i1_pyo, * p_i2_pyo;
+	int64_t ctrl_code = 0;
+	PyObject* p_done = Py_None;
+	if (!PyArg_ParseTuple(args, "LOO|LO", &code, &p_i1_pyo, &p_i2_pyo, &ctrl_code, &p_done)) {
+		return NULL;
+	}
+	TDD<W>* p_tdd = (TDD<W>*)code;
+
+	auto&& size = PyList_GET_SIZE(p_i1_pyo);
+	cache::pair_cmd cmd(size);
+	for (int i = 0; i < size; i++) {
+		cmd[i].first = PyLong_AsLong(PyList_GetItem(p_i1_pyo, i));
+		cmd[i].second = PyLong_AsLong(PyList_GetItem(p_i2_pyo, i));
+	}
+
+	if (p_done != Py_None) {
+		return submit_operation<W>(p_done, [p_tdd, cmd, ctrl_code]() {
+			return p_tdd->trace(cmd, (PyController*)ctrl_code);
+			});
+	}
+
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(p_tdd->trace(cmd, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+
+	// convert to long long
+	int64_t code_res = (int64_t)p_res;
+	return Py_BuildValue("L", code_res);
+}
+
+/// <summary>
+/// return the sliced tdd.
+/// </summary>
+/// <typeparam name="W"></typeparam>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <class W>
+static PyObject*
+slice_tdd(PyObject* self, PyObject* args) {
+	int64_t code;
+	PyObject* p_i_pyo, * p_v_pyo;
+	if (!PyArg_ParseTuple(args, "LOO", &code, &p_i_pyo, &p_v_pyo)) {
+		return NULL;
+	}
+	TDD<W>* p_tdd = (TDD<W>*)code;
+
+	auto size = PyList_GET_SIZE(p_i_pyo);
+	std::vector<int64_t> i_ls(size);
+	std::vector<int64_t> v_ls(size);
+	for (int i = 0; i < size; i++) {
+		i_ls[i] = PyLong_AsLongLong(PyList_GetItem(p_i_pyo, i));
+		v_ls[i] = PyLong_AsLongLong(PyList_GetItem(p_v_pyo, i));
+	}
+
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(p_tdd->slice(i_ls, v_ls));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+
+	// convert to long long
+	int64_t code_res = (int64_t)p_res;
+	return Py_BuildValue("L", code_res);
+}
+
+
+/// <summary>
+/// Return the tensordot of two tdds. The index indication should be a number.
+/// The completion callable can be put in after the controller, for the asynchronous execution (see submit_operation).
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <typename W1, typename W2>
+static PyObject*
+tensordot_num(PyObject* self, PyObject* args) {
+	int64_t code_a, code_b;
+	int dim;
+	PyObject* p_rearrangement_pyo;
+	bool parallel_tensor;
+	int64_t ctrl_code = 0;
+	PyObject* p_done = Py_None;
+	if (!PyArg_ParseTuple(args, "LLiOb|LO", &code_a, &code_b, &dim, &p_rearrangement_pyo, &parallel_tensor, &ctrl_code, &p_done)) {
+		return NULL;
+	}
+	TDD<W1>* p_tdda = (TDD<W1>*)code_a;
+	TDD<W2>* p_tddb = (TDD<W2>*)code_b;
+
+	auto&& size = PyList_GET_SIZE(p_rearrangement_pyo);
+	std::vector<int> rearrangement(size);
+	for (int i = 0; i < size; i++) {
+		rearrangement[i] = PyLong_AsLong(PyList_GetItem(p_rearrangement_pyo, i));
+	}
+
+	if (p_done != Py_None) {
+		return submit_operation<weight::W_C<W1, W2>>(p_done, [p_tdda, p_tddb, dim, rearrangement, parallel_tensor, ctrl_code]() {
+			return tdd::tensordot_num<W1, W2>(*p_tdda, *p_tddb, dim, rearrangement, parallel_tensor, (PyController*)ctrl_code);
+			});
+	}
+
+	TDD<weight::W_C<W1, W2>>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<weight::W_C<W1, W2>>
+			(tdd::tensordot_num<W1, W2>(*p_tdda, *p_tddb, dim, rearrangement, parallel_tensor, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	// convert to long long
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
+}
+
+/// <summary>
+/// Return the tensordot of two tdds. The index indication should be two index lists.
+/// The completion callable can be put in after the controller, for the asynchronous execution (see submit_operation).
+/// </summary>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <typename W1, typename W2>
+static PyObject*
+tensordot_ls(PyObject* self, PyObject* args) {
+	int64_t code_a, code_b;
+	PyObject* p_i1_pyo, * p_i2_pyo, * p_rearrangement_pyo;
+	bool parallel_tensor;
+	int64_t ctrl_code = 0;
+	PyObject* p_done = Py_None;
+	if (!PyArg_ParseTuple(args, "LLOOOb|LO", &code_a, &code_b, &p_i1_pyo, &p_i2_pyo, &p_rearrangement_pyo, &parallel_tensor, &ctrl_code, &p_done)) {
+		return NULL;
+	}
+	TDD<W1>* p_tdda = (TDD<W1>*)code_a;
+	TDD<W2>* p_tddb = (TDD<W2>*)code_b;
+
+	auto size = PyList_GET_SIZE(p_i1_pyo);
+	std::vector<int64_t> i1(size);
+	std::vector<int64_t> i2(size);
+	for (int i = 0; i < size; i++) {
+		i1[i] = PyLong_AsLongLong(PyList_GetItem(p_i1_pyo, i));
+		i2[i] = PyLong_AsLongLong(PyList_GetItem(p_i2_pyo, i));
+	}
+
+	size = PyList_GET_SIZE(p_rearrangement_pyo);
+	std::vector<int> rearrangement(size);
+	for (int i = 0; i < size; i++) {
+		rearrangement[i] = PyLong_AsLong(PyList_GetItem(p_rearrangement_pyo, i));
+	}
+
+	if (p_done != Py_None) {
+		return submit_operation<weight::W_C<W1, W2>>(p_done, [p_tdda, p_tddb, i1, i2, rearrangement, parallel_tensor, ctrl_code]() {
+			return tdd::tensordot<W1, W2>(*p_tdda, *p_tddb, i1, i2, rearrangement, parallel_tensor, (PyController*)ctrl_code);
+			});
 	}
-	TDD<W>* p_tdda = (TDD<W>*)code_a;
-	TDD<W>* p_tddb = (TDD<W>*)code_b;
 
+	TDD<weight::W_C<W1, W2>>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<weight::W_C<W1, W2>>
+			(tdd::tensordot<W1, W2>(*p_tdda, *p_tddb, i1, i2, rearrangement, parallel_tensor, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
-	auto&& p_res = new TDD<W>(TDD<W>::sum(*p_tdda, *p_tddb));
 	// convert to long long
 	int64_t code = (int64_t)p_res;
 	return Py_BuildValue("L", code);
@@ -221,110 +1079,189 @@ sum(PyObject* self, PyObject* args) {
 
 
 /// <summary>
-/// Trace the designated indices of the given tdd.
+/// Return the tensordot of two tdds, sliced on the given result indices. The slicing is pushed down to the operands.
 /// </summary>
-/// <typeparam name="W"></typeparam>
+/// <typeparam name="W1"></typeparam>
+/// <typeparam name="W2"></typeparam>
 /// <param name="self"></param>
 /// <param name="args"></param>
 /// <returns></returns>
-template <class W>
+template <typename W1, typename W2>
 static PyObject*
-trace(PyObject* self, PyObject* args) {
-	int64_t code;
-	PyObject* p_i1_pyo, * p_i2_pyo;
-	if (!PyArg_ParseTuple(args, "LOO", &code, &p_i1_pyo, &p_i2_pyo)) {
+tensordot_sliced(PyObject* self, PyObject* args) {
+	int64_t code_a, code_b;
+	PyObject* p_i1_pyo, * p_i2_pyo, * p_indices_pyo, * p_values_pyo, * p_rearrangement_pyo;
+	bool parallel_tensor;
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "LLOOOOOb|L", &code_a, &code_b, &p_i1_pyo, &p_i2_pyo,
+		&p_indices_pyo, &p_values_pyo, &p_rearrangement_pyo, &parallel_tensor, &ctrl_code)) {
 		return NULL;
 	}
-	TDD<W>* p_tdd = (TDD<W>*)code;
+	TDD<W1>* p_tdda = (TDD<W1>*)code_a;
+	TDD<W2>* p_tddb = (TDD<W2>*)code_b;
 
-	auto&& size = PyList_GET_SIZE(p_i1_pyo);
-	cache::pair_cmd cmd(size);
+	auto size = PyList_GET_SIZE(p_i1_pyo);
+	std::vector<int64_t> i1(size);
+	std::vector<int64_t> i2(size);
 	for (int i = 0; i < size; i++) {
-		cmd[i].first = PyLong_AsLong(PyList_GetItem(p_i1_pyo, i));
-		cmd[i].second = PyLong_AsLong(PyList_GetItem(p_i2_pyo, i));
+		i1[i] = PyLong_AsLongLong(PyList_GetItem(p_i1_pyo, i));
+		i2[i] = PyLong_AsLongLong(PyList_GetItem(p_i2_pyo, i));
+	}
+
+	size = PyList_GET_SIZE(p_indices_pyo);
+	std::vector<int64_t> indices(size);
+	std::vector<int64_t> values(size);
+	for (int i = 0; i < size; i++) {
+		indices[i] = PyLong_AsLongLong(PyList_GetItem(p_indices_pyo, i));
+		values[i] = PyLong_AsLongLong(PyList_GetItem(p_values_pyo, i));
+	}
+
+	size = PyList_GET_SIZE(p_rearrangement_pyo);
+	std::vector<int> rearrangement(size);
+	for (int i = 0; i < size; i++) {
+		rearrangement[i] = PyLong_AsLong(PyList_GetItem(p_rearrangement_pyo, i));
 	}
 
-	auto&& p_res = new TDD<W>(p_tdd->trace(cmd));
+	TDD<weight::W_C<W1, W2>>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<weight::W_C<W1, W2>>
+			(tdd::tensordot_sliced<W1, W2>(*p_tdda, *p_tddb, i1, i2, indices, values,
+				rearrangement, parallel_tensor, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
-	int64_t code_res = (int64_t)p_res;
-	return Py_BuildValue("L", code_res);
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
 }
 
+
 /// <summary>
-/// return the sliced tdd.
+/// Return the tensordot of two tdds, traced on the given pairs of result indices.
 /// </summary>
-/// <typeparam name="W"></typeparam>
+/// <typeparam name="W1"></typeparam>
+/// <typeparam name="W2"></typeparam>
 /// <param name="self"></param>
 /// <param name="args"></param>
 /// <returns></returns>
-template <class W>
+template <typename W1, typename W2>
 static PyObject*
-slice_tdd(PyObject* self, PyObject* args) {
-	int64_t code;
-	PyObject* p_i_pyo, * p_v_pyo;
-	if (!PyArg_ParseTuple(args, "LOO", &code, &p_i_pyo, &p_v_pyo)) {
+tensordot_trace(PyObject* self, PyObject* args) {
+	int64_t code_a, code_b;
+	PyObject* p_i1_pyo, * p_i2_pyo, * p_t1_pyo, * p_t2_pyo, * p_rearrangement_pyo;
+	bool parallel_tensor;
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "LLOOOOOb|L", &code_a, &code_b, &p_i1_pyo, &p_i2_pyo,
+		&p_t1_pyo, &p_t2_pyo, &p_rearrangement_pyo, &parallel_tensor, &ctrl_code)) {
 		return NULL;
 	}
-	TDD<W>* p_tdd = (TDD<W>*)code;
+	TDD<W1>* p_tdda = (TDD<W1>*)code_a;
+	TDD<W2>* p_tddb = (TDD<W2>*)code_b;
 
-	auto size = PyList_GET_SIZE(p_i_pyo);
-	std::vector<int64_t> i_ls(size);
-	std::vector<int64_t> v_ls(size);
+	auto size = PyList_GET_SIZE(p_i1_pyo);
+	std::vector<int64_t> i1(size);
+	std::vector<int64_t> i2(size);
 	for (int i = 0; i < size; i++) {
-		i_ls[i] = PyLong_AsLongLong(PyList_GetItem(p_i_pyo, i));
-		v_ls[i] = PyLong_AsLongLong(PyList_GetItem(p_v_pyo, i));
+		i1[i] = PyLong_AsLongLong(PyList_GetItem(p_i1_pyo, i));
+		i2[i] = PyLong_AsLongLong(PyList_GetItem(p_i2_pyo, i));
+	}
+
+	size = PyList_GET_SIZE(p_t1_pyo);
+	cache::pair_cmd trace_pairs(size);
+	for (int i = 0; i < size; i++) {
+		trace_pairs[i].first = PyLong_AsLong(PyList_GetItem(p_t1_pyo, i));
+		trace_pairs[i].second = PyLong_AsLong(PyList_GetItem(p_t2_pyo, i));
+	}
+
+	size = PyList_GET_SIZE(p_rearrangement_pyo);
+	std::vector<int> rearrangement(size);
+	for (int i = 0; i < size; i++) {
+		rearrangement[i] = PyLong_AsLong(PyList_GetItem(p_rearrangement_pyo, i));
 	}
 
-	auto&& p_res = new TDD<W>(p_tdd->slice(i_ls, v_ls));
+	TDD<weight::W_C<W1, W2>>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<weight::W_C<W1, W2>>
+			(tdd::tensordot_trace<W1, W2>(*p_tdda, *p_tddb, i1, i2, trace_pairs,
+				rearrangement, parallel_tensor, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
-	int64_t code_res = (int64_t)p_res;
-	return Py_BuildValue("L", code_res);
+	int64_t code = (int64_t)p_res;
+	return Py_BuildValue("L", code);
 }
 
 
 /// <summary>
-/// Return the tensordot of two tdds. The index indication should be a number.
+/// Return the tensordot of two tdds, with the contraction sliced and run across the threads.
 /// </summary>
+/// <typeparam name="W1"></typeparam>
+/// <typeparam name="W2"></typeparam>
 /// <param name="self"></param>
 /// <param name="args"></param>
 /// <returns></returns>
 template <typename W1, typename W2>
 static PyObject*
-tensordot_num(PyObject* self, PyObject* args) {
+tensordot_hsf(PyObject* self, PyObject* args) {
 	int64_t code_a, code_b;
-	int dim;
-	PyObject* p_rearrangement_pyo;
+	PyObject* p_i1_pyo, * p_i2_pyo, * p_rearrangement_pyo;
+	double slice_budget;
 	bool parallel_tensor;
-	if (!PyArg_ParseTuple(args, "LLiOb", &code_a, &code_b, &dim, &p_rearrangement_pyo, &parallel_tensor)) {
+	int64_t ctrl_code = 0;
+	if (!PyArg_ParseTuple(args, "LLOOdOb|L", &code_a, &code_b, &p_i1_pyo, &p_i2_pyo,
+		&slice_budget, &p_rearrangement_pyo, &parallel_tensor, &ctrl_code)) {
 		return NULL;
 	}
 	TDD<W1>* p_tdda = (TDD<W1>*)code_a;
 	TDD<W2>* p_tddb = (TDD<W2>*)code_b;
 
-	auto&& size = PyList_GET_SIZE(p_rearrangement_pyo);
+	auto size = PyList_GET_SIZE(p_i1_pyo);
+	std::vector<int64_t> i1(size);
+	std::vector<int64_t> i2(size);
+	for (int i = 0; i < size; i++) {
+		i1[i] = PyLong_AsLongLong(PyList_GetItem(p_i1_pyo, i));
+		i2[i] = PyLong_AsLongLong(PyList_GetItem(p_i2_pyo, i));
+	}
+
+	size = PyList_GET_SIZE(p_rearrangement_pyo);
 	std::vector<int> rearrangement(size);
 	for (int i = 0; i < size; i++) {
 		rearrangement[i] = PyLong_AsLong(PyList_GetItem(p_rearrangement_pyo, i));
 	}
 
-	auto&& p_res = new TDD<weight::W_C<W1, W2>>
-		(tdd::tensordot_num<W1, W2>(*p_tdda, *p_tddb, dim, rearrangement, parallel_tensor));
+	TDD<weight::W_C<W1, W2>>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<weight::W_C<W1, W2>>
+			(tdd::tensordot_hsf<W1, W2>(*p_tdda, *p_tddb, i1, i2, slice_budget,
+				rearrangement, parallel_tensor, (PyController*)ctrl_code));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+
 	// convert to long long
 	int64_t code = (int64_t)p_res;
 	return Py_BuildValue("L", code);
 }
 
+
 /// <summary>
-/// Return the tensordot of two tdds. The index indication should be two index lists.
+/// Estimate the cost of tensordot without executing it. Return a dictionary.
 /// </summary>
 /// <param name="self"></param>
 /// <param name="args"></param>
 /// <returns></returns>
 template <typename W1, typename W2>
 static PyObject*
-tensordot_ls(PyObject* self, PyObject* args) {
+estimate_tensordot(PyObject* self, PyObject* args) {
 	int64_t code_a, code_b;
 	PyObject* p_i1_pyo, * p_i2_pyo, * p_rearrangement_pyo;
 	bool parallel_tensor;
@@ -348,12 +1285,25 @@ tensordot_ls(PyObject* self, PyObject* args) {
 		rearrangement[i] = PyLong_AsLong(PyList_GetItem(p_rearrangement_pyo, i));
 	}
 
-	auto&& p_res = new TDD<weight::W_C<W1, W2>>
-		(tdd::tensordot<W1, W2>(*p_tdda, *p_tddb, i1, i2, rearrangement, parallel_tensor));
+	tdd::cont_estimate res;
+	try {
+		EngineScope scope;
+		res = tdd::estimate_tensordot<W1, W2>(*p_tdda, *p_tddb, i1, i2, rearrangement, parallel_tensor);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+
+	auto&& py_level_nodes = PyTuple_New(res.level_nodes.size());
+	for (int i = 0; i < res.level_nodes.size(); i++) {
+		PyTuple_SetItem(py_level_nodes, i, PyFloat_FromDouble(res.level_nodes[i]));
+	}
 
-	// convert to long long
-	int64_t code = (int64_t)p_res;
-	return Py_BuildValue("L", code);
+	return Py_BuildValue("{sNsdsdsd}",
+		"level nodes", py_level_nodes,
+		"nodes", res.nodes,
+		"work", res.work,
+		"time", res.time);
 }
 
 
@@ -379,7 +1329,14 @@ permute(PyObject* self, PyObject* args) {
 		new_order[i] = PyLong_AsLongLong(PyList_GetItem(p_new_order_ls, i));
 	}
 
-	auto&& p_res = new TDD<W>(p_tdd->permute(new_order));
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(p_tdd->permute(new_order));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
 	int64_t res_code = (int64_t)p_res;
@@ -404,7 +1361,14 @@ conj(PyObject* self, PyObject* args) {
 	}
 	TDD<W>* p_tdd = (TDD<W>*)code;
 
-	auto&& p_res = new TDD<W>(p_tdd->conj());
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(p_tdd->conj());
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
 	int64_t res_code = (int64_t)p_res;
@@ -427,7 +1391,14 @@ norm(PyObject* self, PyObject* args) {
 	}
 	TDD<W>* p_tdd = (TDD<W>*)code;
 
-	auto&& p_res = new TDD<W>(p_tdd->norm());
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(p_tdd->norm());
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
 	int64_t res_code = (int64_t)p_res;
@@ -453,7 +1424,14 @@ mul__w(PyObject* self, PyObject* args) {
 	TDD<W>* p_tdd = (TDD<W>*)code;
 	wcomplex weight(py_weight.real, py_weight.imag);
 
-	auto&& p_res = new TDD<W>(tdd::operator*(*p_tdd, weight));
+	TDD<W>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<W>(tdd::operator*(*p_tdd, weight));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
 	int64_t res_code = (int64_t)p_res;
@@ -478,7 +1456,14 @@ mul_tt(PyObject* self, PyObject* args) {
 	auto&& t = THPVariable_Unpack(p_tensor);
 	TDD<CUDAcpl::Tensor>* p_tdd = (TDD<CUDAcpl::Tensor>*)code;
 
-	auto&& p_res = new TDD<CUDAcpl::Tensor>(tdd::operator*(*p_tdd, t));
+	TDD<CUDAcpl::Tensor>* p_res;
+	try {
+		EngineScope scope;
+		p_res = new TDD<CUDAcpl::Tensor>(tdd::operator*(*p_tdd, t));
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	// convert to long long
 	int64_t res_code = (int64_t)p_res;
@@ -506,13 +1491,23 @@ get_tdd_info(PyObject* self, PyObject* args) {
 	}
 	TDD<W>* p_tdd = (TDD<W>*)code;
 
-	auto&& tdd_weight = p_tdd->w_node().weight;
-	auto&& tdd_node = p_tdd->w_node().get_node();
-	auto&& tdd_dim_parallel = p_tdd->parallel_shape().size();
-	auto&& tdd_dim_data = p_tdd->dim_data();
-	auto&& tdd_p_parallel_shape = p_tdd->parallel_shape();
-	auto&& tdd_p_data_shape = p_tdd->data_shape();
-	auto&& tdd_p_storage_order = p_tdd->storage_order();
+	// copy the information, for the tdd can be reordered in place by other threads
+	W tdd_weight;
+	const Node<W>* tdd_node;
+	std::vector<int64_t> tdd_p_parallel_shape, tdd_p_data_shape, tdd_p_storage_order;
+	try {
+		EngineScope scope;
+		tdd_weight = p_tdd->w_node().weight;
+		tdd_node = p_tdd->w_node().get_node();
+		tdd_p_parallel_shape = p_tdd->parallel_shape();
+		tdd_p_data_shape = p_tdd->data_shape();
+		tdd_p_storage_order = p_tdd->storage_order();
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+	auto&& tdd_dim_parallel = tdd_p_parallel_shape.size();
+	auto&& tdd_dim_data = (int64_t)tdd_p_storage_order.size();
 
 	// prepare the objects
 	auto&& py_weight = THPVariable_Wrap(weight::from_weight(tdd_weight));
@@ -561,7 +1556,69 @@ get_tdd_size(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 	TDD<W>* p_tdd = (TDD<W>*)code;
-	auto&& size = p_tdd->size();
+	int size;
+	try {
+		EngineScope scope;
+		size = p_tdd->size();
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+
+	return PyLong_FromLong(size);
+}
+
+/// <summary>
+/// Swap the inner levels (level, level + 1) of the tdd in place.
+/// </summary>
+/// <typeparam name="W"></typeparam>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <class W>
+static PyObject*
+swap_levels(PyObject* self, PyObject* args) {
+	int64_t code;
+	int level;
+	if (!PyArg_ParseTuple(args, "Li", &code, &level)) {
+		return NULL;
+	}
+	TDD<W>* p_tdd = (TDD<W>*)code;
+	try {
+		EngineScope scope;
+		p_tdd->swap_levels(level);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
+
+	return Py_BuildValue("");
+}
+
+/// <summary>
+/// Reorder the tdd in place by sifting, and return the size after reordering.
+/// </summary>
+/// <typeparam name="W"></typeparam>
+/// <param name="self"></param>
+/// <param name="args"></param>
+/// <returns></returns>
+template <class W>
+static PyObject*
+sift(PyObject* self, PyObject* args) {
+	int64_t code;
+	double max_growth;
+	if (!PyArg_ParseTuple(args, "Ld", &code, &max_growth)) {
+		return NULL;
+	}
+	TDD<W>* p_tdd = (TDD<W>*)code;
+	int size;
+	try {
+		EngineScope scope;
+		size = p_tdd->sift(max_growth);
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	return PyLong_FromLong(size);
 }
@@ -582,16 +1639,27 @@ get_node_info(PyObject* self, PyObject* args) {
 	}
 	Node<W>* p_node = (Node<W>*)code;
 
-	auto&& node_order = p_node->get_order();
-	auto&& node_range = p_node->get_range();
-	auto&& node_ref_count = p_node->get_ref_count();
-	auto&& node_successors = p_node->get_successors();
+	// copy the weights and the node pointers only, for the weighted nodes hold the reference counts
+	int node_order, node_range, node_ref_count;
+	std::vector<std::pair<W, const Node<W>*>> node_successors;
+	try {
+		EngineScope scope;
+		node_order = p_node->get_order();
+		node_range = p_node->get_range();
+		node_ref_count = p_node->get_ref_count();
+		for (auto&& succ : p_node->get_successors()) {
+			node_successors.emplace_back(succ.weight, succ.get_node());
+		}
+	}
+	catch (...) {
+		return set_engine_error();
+	}
 
 	auto&& py_successors = PyTuple_New(node_range);
 	for (int i = 0; i < node_range; i++) {
 		auto&& temp_succ = Py_BuildValue("{sOsO}",
-			"weight", THPVariable_Wrap(weight::from_weight(node_successors[i].weight)),
-			"node", PyLong_FromLongLong((int64_t)node_successors[i].get_node()));
+			"weight", THPVariable_Wrap(weight::from_weight(node_successors[i].first)),
+			"node", PyLong_FromLongLong((int64_t)node_successors[i].second));
 		
 		PyTuple_SetItem(py_successors, i, temp_succ);
 	}
@@ -606,21 +1674,303 @@ get_node_info(PyObject* self, PyObject* args) {
 
 
 
+/// <summary>
+/// The native tdd object of python, which holds the tdd (of scalar or tensor weight) inline.
+/// The address of the inline tdd is exposed as the pointer, so that the functions taking tdd pointers still apply.
+/// Note that the tdds are created, moved and destroyed with the engine lock held, for they are registered globally.
+/// </summary>
+using tdd_variant = std::variant<std::monostate, TDD<wcomplex>, TDD<CUDAcpl::Tensor>>;
+
+struct PyTDD {
+	PyObject_HEAD
+	tdd_variant tdd;
+};
+
+/// <summary>
+/// Allocate the object of the given type (TDDBase or the python subclass), holding no tdd.
+/// </summary>
+static PyTDD*
+tdd_alloc(PyTypeObject* p_type) {
+	auto&& p_res = (PyTDD*)p_type->tp_alloc(p_type, 0);
+	if (p_res) {
+		new (&p_res->tdd) tdd_variant();
+	}
+	return p_res;
+}
+
+/// <summary>
+/// Apply f on the tdd held by the object, or raise ValueError if there is none.
+/// </summary>
+template <class F>
+static PyObject*
+tdd_visit(PyObject* self, F&& f) {
+	auto&& tdd = ((PyTDD*)self)->tdd;
+	if (auto p_tdd = std::get_if<TDD<wcomplex>>(&tdd)) {
+		return f(*p_tdd);
+	}
+	if (auto p_tdd = std::get_if<TDD<CUDAcpl::Tensor>>(&tdd)) {
+		return f(*p_tdd);
+	}
+	PyErr_SetString(PyExc_ValueError, "the tdd object is not initialized.");
+	return NULL;
+}
+
+/// <summary>
+/// Read the sequence of integers. Return false with the python exception set if it fails.
+/// </summary>
+static bool
+read_int_sequence(PyObject* p_seq, std::vector<int64_t>& res) {
+	auto&& p_fast = PySequence_Fast(p_seq, "a sequence of integers is expected.");
+	if (p_fast == NULL) {
+		return false;
+	}
+	auto&& size = PySequence_Fast_GET_SIZE(p_fast);
+	auto&& p_items = PySequence_Fast_ITEMS(p_fast);
+	res.resize(size);
+	for (Py_ssize_t i = 0; i < size; i++) {
+		res[i] = PyLong_AsLongLong(p_items[i]);
+	}
+	Py_DECREF(p_fast);
+	return !PyErr_Occurred();
+}
+
+static PyObject*
+tdd_new(PyTypeObject* p_type, PyObject* args, PyObject* kwds) {
+	return (PyObject*)tdd_alloc(p_type);
+}
+
+/// <summary>
+/// Take the ownership of the tdd pointer returned by the functions of this module, moving the tdd inline.
+/// </summary>
+/// <param name="args">the pointer to the tdd, and whether it is of tensor weight</param>
+static int
+tdd_init(PyObject* self, PyObject* args, PyObject* kwds) {
+	int64_t code;
+	bool tensor_weight;
+	if (!PyArg_ParseTuple(args, "Lb", &code, &tensor_weight)) {
+		return -1;
+	}
+	try {
+		EngineScope scope;
+		if (tensor_weight) {
+			auto&& p_tdd = (TDD<CUDAcpl::Tensor>*)code;
+			((PyTDD*)self)->tdd.emplace<TDD<CUDAcpl::Tensor>>(std::move(*p_tdd));
+			delete p_tdd;
+		}
+		else {
+			auto&& p_tdd = (TDD<wcomplex>*)code;
+			((PyTDD*)self)->tdd.emplace<TDD<wcomplex>>(std::move(*p_tdd));
+			delete p_tdd;
+		}
+	}
+	catch (...) {
+		set_engine_error();
+		return -1;
+	}
+	return 0;
+}
+
+static void
+tdd_dealloc(PyObject* self) {
+	auto&& p_type = Py_TYPE(self);
+	{
+		EngineScope scope;
+		((PyTDD*)self)->tdd.~tdd_variant();
+	}
+	p_type->tp_free(self);
+	Py_DECREF(p_type);
+}
+
+static PyObject*
+tdd_get_pointer(PyObject* self, void* closure) {
+	return tdd_visit(self, [](auto& tdd) {
+		return PyLong_FromLongLong((int64_t)&tdd);
+		});
+}
+
+static PyObject*
+tdd_get_tensor_weight(PyObject* self, void* closure) {
+	return PyBool_FromLong(std::holds_alternative<TDD<CUDAcpl::Tensor>>(((PyTDD*)self)->tdd));
+}
+
+static PyObject*
+tdd_size(PyObject* self, PyObject* unused) {
+	return tdd_visit(self, [](auto& tdd) -> PyObject* {
+		int size;
+		try {
+			EngineScope scope;
+			size = tdd.size();
+		}
+		catch (...) {
+			return set_engine_error();
+		}
+		return PyLong_FromLong(size);
+		});
+}
+
+static PyObject*
+tdd_conj(PyObject* self, PyObject* unused) {
+	return tdd_visit(self, [self](auto& tdd) -> PyObject* {
+		using T = std::decay_t<decltype(tdd)>;
+		auto&& p_res = tdd_alloc(Py_TYPE(self));
+		if (p_res) {
+			try {
+				EngineScope scope;
+				p_res->tdd.template emplace<T>(tdd.conj());
+			}
+			catch (...) {
+				Py_DECREF(p_res);
+				return set_engine_error();
+			}
+		}
+		return (PyObject*)p_res;
+		});
+}
+
+/// <summary>
+/// Return the permuted tdd.
+/// </summary>
+/// <param name="args">the permutation</param>
+static PyObject*
+tdd_permute(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+	if (nargs != 1) {
+		PyErr_SetString(PyExc_TypeError, "permute takes exactly one argument (perm).");
+		return NULL;
+	}
+	std::vector<int64_t> perm;
+	if (!read_int_sequence(args[0], perm)) {
+		return NULL;
+	}
+	return tdd_visit(self, [self, &perm](auto& tdd) -> PyObject* {
+		using T = std::decay_t<decltype(tdd)>;
+		auto&& dim = tdd.dim_data();
+		std::vector<bool> repeat(dim, false);
+		bool valid = perm.size() == dim;
+		for (int i = 0; valid && i < perm.size(); i++) {
+			valid = perm[i] >= 0 && perm[i] < dim && !repeat[perm[i]];
+			repeat[valid ? perm[i] : 0] = true;
+		}
+		if (!valid) {
+			PyErr_SetString(PyExc_ValueError, "Given permutation is not valid.");
+			return NULL;
+		}
+		auto&& p_res = tdd_alloc(Py_TYPE(self));
+		if (p_res) {
+			try {
+				EngineScope scope;
+				p_res->tdd.template emplace<T>(tdd.permute(perm));
+			}
+			catch (...) {
+				Py_DECREF(p_res);
+				return set_engine_error();
+			}
+		}
+		return (PyObject*)p_res;
+		});
+}
+
+/// <summary>
+/// Return the tdd sliced at the given indices.
+/// </summary>
+/// <param name="args">the indices and the values</param>
+static PyObject*
+tdd_slice(PyObject* self, PyObject* const* args, Py_ssize_t nargs) {
+	if (nargs != 2) {
+		PyErr_SetString(PyExc_TypeError, "slice takes exactly two arguments (indices, values).");
+		return NULL;
+	}
+	std::vector<int64_t> indices, values;
+	if (!read_int_sequence(args[0], indices) || !read_int_sequence(args[1], values)) {
+		return NULL;
+	}
+	return tdd_visit(self, [self, &indices, &values](auto& tdd) -> PyObject* {
+		using T = std::decay_t<decltype(tdd)>;
+		auto&& dim = tdd.dim_data();
+		std::vector<bool> repeat(dim, false);
+		bool valid = indices.size() == values.size();
+		for (int i = 0; valid && i < indices.size(); i++) {
+			valid = indices[i] >= 0 && indices[i] < dim && !repeat[indices[i]]
+				&& values[i] >= 0 && values[i] < tdd.data_shape()[indices[i]];
+			repeat[valid ? indices[i] : 0] = true;
+		}
+		if (!valid) {
+			PyErr_SetString(PyExc_ValueError, "Given indices or values are not valid.");
+			return NULL;
+		}
+		auto&& p_res = tdd_alloc(Py_TYPE(self));
+		if (p_res) {
+			try {
+				EngineScope scope;
+				p_res->tdd.template emplace<T>(tdd.slice(indices, values));
+			}
+			catch (...) {
+				Py_DECREF(p_res);
+				return set_engine_error();
+			}
+		}
+		return (PyObject*)p_res;
+		});
+}
+
+static PyGetSetDef tdd_getset[] = {
+	{ "pointer", (getter)tdd_get_pointer, nullptr, "the pointer to the tdd held inline", nullptr },
+	{ "tensor_weight", (getter)tdd_get_tensor_weight, nullptr, "whether the tdd is of tensor weight", nullptr },
+	{ nullptr, nullptr, nullptr, nullptr, nullptr }
+};
+
+static PyMethodDef tdd_methods[] = {
+	{ "size", (PyCFunction)tdd_size, METH_NOARGS, "Return the size (non-terminal nodes) of the tdd." },
+	{ "conj", (PyCFunction)tdd_conj, METH_NOARGS, "Return the conjugate of the tdd. Note that the coordinator information is not changed." },
+	{ "permute", (PyCFunction)(void(*)(void))tdd_permute, METH_FASTCALL, "Return the tdd with the indices permuted (a view, without new nodes)." },
+	{ "slice", (PyCFunction)(void(*)(void))tdd_slice, METH_FASTCALL, "Return the tdd sliced at the given indices with the given values." },
+	{ nullptr, nullptr, 0, nullptr }
+};
+
+static PyType_Slot tdd_slots[] = {
+	{ Py_tp_doc, (void*)"The native tdd object, holding the tdd inline. The python class TDD derives from it." },
+	{ Py_tp_new, (void*)tdd_new },
+	{ Py_tp_init, (void*)tdd_init },
+	{ Py_tp_dealloc, (void*)tdd_dealloc },
+	{ Py_tp_getset, (void*)tdd_getset },
+	{ Py_tp_methods, (void*)tdd_methods },
+	{ 0, nullptr }
+};
+
+static PyType_Spec tdd_spec = {
+	"ctdd.TDDBase",
+	sizeof(PyTDD),
+	0,
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+	tdd_slots
+};
+
+
 static PyMethodDef ctdd_methods[] = {
 	{ "test", (PyCFunction)test, METH_VARARGS, "this method is for testing purpose" },
 	
 	{ "get_config", (PyCFunction)get_config, METH_VARARGS, "return the current configuration in a dictionary" },
-	{ "delete_tdd", (PyCFunction)delete_tdd<wcomplex>, METH_VARARGS, "delete the tdd passed in (garbage collection)" },
-	{ "delete_tdd_T", (PyCFunction)delete_tdd<CUDAcpl::Tensor>, METH_VARARGS, "delete the tdd passed in (garbage collection)" },
 	{ "clear_garbage", (PyCFunction)clear_garbage, METH_VARARGS, " clear the garbage only." },
 	{ "clear_cache", (PyCFunction)clear_cache, METH_VARARGS, " clear all the caches." },
 	{ "reset", (PyCFunction)reset, METH_VARARGS, " reset the system and update the settings." },
+	{ "set_stack_cont_depth", (PyCFunction)set_stack_cont_depth, METH_VARARGS, "set the total level number beyond which the contraction is conducted with the explicit frame stack. 0 for always." },
+	{ "controller_new", (PyCFunction)controller_new, METH_VARARGS, "Create a controller and return the pointer." },
+	{ "controller_cancel", (PyCFunction)controller_cancel, METH_VARARGS, "Cancel the operation supervised by the controller." },
+	{ "controller_reset", (PyCFunction)controller_reset, METH_VARARGS, "Clear the cancellation, so that the controller can be reused." },
+	{ "controller_progress", (PyCFunction)controller_progress, METH_VARARGS, "Return the progress of the (last) operation supervised by the controller in a dictionary." },
+	{ "controller_delete", (PyCFunction)controller_delete, METH_VARARGS, "delete the controller passed in" },
 	{ "as_tensor", (PyCFunction)as_tensor<wcomplex>, METH_VARARGS, "Take in the CUDAcpl tensor, transform to TDD and returns the pointer." },
 	{ "as_tensor_T", (PyCFunction)as_tensor<CUDAcpl::Tensor>, METH_VARARGS, "Take in the CUDAcpl tensor, transform to TDD and returns the pointer." },
+	{ "as_buffer", (PyCFunction)as_buffer, METH_VARARGS, "Take in the object of the complex128 buffer, transform to TDD and returns the pointer." },
+	{ "as_sparse", (PyCFunction)as_sparse, METH_VARARGS, "Take in the sparse tensor in the COO format, transform to TDD and returns the pointer." },
+	{ "circuit", (PyCFunction)circuit_tdd, METH_VARARGS, "Simulate the whole circuit in C++, and return the pointer to the tdd of the unitary (or the state)." },
 	{ "as_tensor_clone", (PyCFunction)as_tensor_clone<wcomplex>, METH_VARARGS, "Return the cloned tdd." },
 	{ "as_tensor_clone_T", (PyCFunction)as_tensor_clone<CUDAcpl::Tensor>, METH_VARARGS, "Return the cloned tdd." },
 	{ "to_CUDAcpl", (PyCFunction)to_CUDAcpl<wcomplex>, METH_VARARGS, "Return the python torch tensor of the given tdd." },
 	{ "to_CUDAcpl_T", (PyCFunction)to_CUDAcpl<CUDAcpl::Tensor>, METH_VARARGS, "Return the python torch tensor of the given tdd." },
+	{ "to_buffer", (PyCFunction)to_buffer, METH_VARARGS, "Write the given tdd into the writable object of the complex128 buffer directly." },
+	{ "sample", (PyCFunction)sample, METH_VARARGS, "Draw samples of the index values from the tdd, with the probability proportional to the squared magnitude." },
+	{ "to_CUDAcpl_into", (PyCFunction)to_CUDAcpl_into<wcomplex>, METH_VARARGS, "Write the given tdd into the python torch tensor directly." },
+	{ "to_CUDAcpl_into_T", (PyCFunction)to_CUDAcpl_into<CUDAcpl::Tensor>, METH_VARARGS, "Write the given tdd into the python torch tensor directly." },
 	{ "sum_W", (PyCFunction)sum<wcomplex>, METH_VARARGS, "Return the sum of the two tdds." },
 	{ "sum_T", (PyCFunction)sum<CUDAcpl::Tensor>, METH_VARARGS, "Return the sum of the two tdds." },
 	{ "trace", (PyCFunction)trace<wcomplex>, METH_VARARGS, "Trace the designated indices of the given tdd." },
@@ -635,6 +1985,22 @@ static PyMethodDef ctdd_methods[] = {
 	{ "tensordot_ls_WT", (PyCFunction)tensordot_ls<wcomplex, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds. The index indication should be two index lists." },
 	{ "tensordot_ls_TW", (PyCFunction)tensordot_ls<CUDAcpl::Tensor, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds. The index indication should be two index lists." },
 	{ "tensordot_ls_TT", (PyCFunction)tensordot_ls<CUDAcpl::Tensor, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds. The index indication should be two index lists." },
+	{ "tensordot_sliced_WW", (PyCFunction)tensordot_sliced<wcomplex, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds, sliced on the given result indices." },
+	{ "tensordot_sliced_WT", (PyCFunction)tensordot_sliced<wcomplex, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds, sliced on the given result indices." },
+	{ "tensordot_sliced_TW", (PyCFunction)tensordot_sliced<CUDAcpl::Tensor, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds, sliced on the given result indices." },
+	{ "tensordot_sliced_TT", (PyCFunction)tensordot_sliced<CUDAcpl::Tensor, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds, sliced on the given result indices." },
+	{ "tensordot_trace_WW", (PyCFunction)tensordot_trace<wcomplex, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds, traced on the given pairs of result indices." },
+	{ "tensordot_trace_WT", (PyCFunction)tensordot_trace<wcomplex, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds, traced on the given pairs of result indices." },
+	{ "tensordot_trace_TW", (PyCFunction)tensordot_trace<CUDAcpl::Tensor, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds, traced on the given pairs of result indices." },
+	{ "tensordot_trace_TT", (PyCFunction)tensordot_trace<CUDAcpl::Tensor, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds, traced on the given pairs of result indices." },
+	{ "tensordot_hsf_WW", (PyCFunction)tensordot_hsf<wcomplex, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds, with the contraction sliced and run across the threads." },
+	{ "tensordot_hsf_WT", (PyCFunction)tensordot_hsf<wcomplex, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds, with the contraction sliced and run across the threads." },
+	{ "tensordot_hsf_TW", (PyCFunction)tensordot_hsf<CUDAcpl::Tensor, wcomplex>, METH_VARARGS, "Return the tensordot of two tdds, with the contraction sliced and run across the threads." },
+	{ "tensordot_hsf_TT", (PyCFunction)tensordot_hsf<CUDAcpl::Tensor, CUDAcpl::Tensor>, METH_VARARGS, "Return the tensordot of two tdds, with the contraction sliced and run across the threads." },
+	{ "estimate_tensordot_WW", (PyCFunction)estimate_tensordot<wcomplex, wcomplex>, METH_VARARGS, "Estimate the cost of tensordot without executing it. Return a dictionary." },
+	{ "estimate_tensordot_WT", (PyCFunction)estimate_tensordot<wcomplex, CUDAcpl::Tensor>, METH_VARARGS, "Estimate the cost of tensordot without executing it. Return a dictionary." },
+	{ "estimate_tensordot_TW", (PyCFunction)estimate_tensordot<CUDAcpl::Tensor, wcomplex>, METH_VARARGS, "Estimate the cost of tensordot without executing it. Return a dictionary." },
+	{ "estimate_tensordot_TT", (PyCFunction)estimate_tensordot<CUDAcpl::Tensor, CUDAcpl::Tensor>, METH_VARARGS, "Estimate the cost of tensordot without executing it. Return a dictionary." },
 	{ "permute", (PyCFunction)permute<wcomplex>, METH_VARARGS, "Return the permuted tdd." },
 	{ "permute_T", (PyCFunction)permute<CUDAcpl::Tensor>, METH_VARARGS, "Return the permuted tdd." },
 	{ "conj", (PyCFunction)conj<wcomplex>, METH_VARARGS, "Return the conjugate of the tdd." },
@@ -648,6 +2014,10 @@ static PyMethodDef ctdd_methods[] = {
 	{ "get_tdd_info_T", (PyCFunction)get_tdd_info<CUDAcpl::Tensor>, METH_VARARGS, "Get the information of a tdd. Return a dictionary." },
 	{ "get_tdd_size", (PyCFunction)get_tdd_size<wcomplex>, METH_VARARGS, "Get the size (non-terminal nodes) of the tdd." },
 	{ "get_tdd_size_T", (PyCFunction)get_tdd_size<CUDAcpl::Tensor>, METH_VARARGS, "Get the size (non-terminal nodes) of the tdd." },
+	{ "swap_levels", (PyCFunction)swap_levels<wcomplex>, METH_VARARGS, "Swap two adjacent inner levels of the tdd in place." },
+	{ "swap_levels_T", (PyCFunction)swap_levels<CUDAcpl::Tensor>, METH_VARARGS, "Swap two adjacent inner levels of the tdd in place." },
+	{ "sift", (PyCFunction)sift<wcomplex>, METH_VARARGS, "Reorder the tdd in place by sifting. Return the size after reordering." },
+	{ "sift_T", (PyCFunction)sift<CUDAcpl::Tensor>, METH_VARARGS, "Reorder the tdd in place by sifting. Return the size after reordering." },
 	{ "get_node_info", (PyCFunction)get_node_info<wcomplex>, METH_VARARGS, "Get the information of a node. Return a dictionary." },
 	{ "get_node_info_T", (PyCFunction)get_node_info<CUDAcpl::Tensor>, METH_VARARGS, "Get the information of a node. Return a dictionary." },
 	// Terminate the array with an object containing nulls.
@@ -665,5 +2035,25 @@ static PyModuleDef ctdd = {
 PyMODINIT_FUNC PyInit_ctdd() {
 	get_current_process();
 	reset();
-	return PyModule_Create(&ctdd);
+	auto&& p_module = PyModule_Create(&ctdd);
+	if (p_module == NULL) {
+		return NULL;
+	}
+
+	CancelledError = PyErr_NewException("ctdd.Cancelled", PyExc_RuntimeError, NULL);
+	Py_XINCREF(CancelledError);
+	if (PyModule_AddObject(p_module, "Cancelled", CancelledError) < 0) {
+		Py_XDECREF(CancelledError);
+		Py_CLEAR(CancelledError);
+		Py_DECREF(p_module);
+		return NULL;
+	}
+
+	auto&& p_tdd_type = PyType_FromSpec(&tdd_spec);
+	if (p_tdd_type == NULL || PyModule_AddObject(p_module, "TDDBase", p_tdd_type) < 0) {
+		Py_XDECREF(p_tdd_type);
+		Py_DECREF(p_module);
+		return NULL;
+	}
+	return p_module;
 }
\ No newline at end of file
@@ -0,0 +1,212 @@
+#pragma once
+#include "tdd.hpp"
+
+/// <summary>
+/// The gate library, which constructs the tdds of gates directly as nodes in the unique table, without dense tensors.
+/// A gate on n qubits has the indices (out_0, ..., out_{n-1}, in_0, ..., in_{n-1}), the same as the dense matrix
+/// reshaped to [2]*2n, and is stored in the order (out_0, in_0, out_1, in_1, ...), so that the size of a controlled gate
+/// grows linearly with the number of qubits.
+/// </summary>
+namespace gates {
+
+	/// <summary>
+	/// The storage order (out_0, in_0, out_1, in_1, ...) of gates on num_qubits qubits.
+	/// </summary>
+	inline std::vector<int64_t> gate_storage_order(int num_qubits) {
+		std::vector<int64_t> storage_order(2 * num_qubits);
+		for (int i = 0; i < num_qubits; i++) {
+			storage_order[2 * i] = i;
+			storage_order[2 * i + 1] = num_qubits + i;
+		}
+		return storage_order;
+	}
+
+	template <class W>
+	inline node::weightednode<W> terminal(const W& value) {
+		return node::weightednode<W>(W{ value }, nullptr);
+	}
+
+	/// <summary>
+	/// Return the weighted node of the operator on the qubit at depth (out) and depth+1 (in),
+	/// whose matrix elements are the operators on the rest qubits.
+	/// </summary>
+	/// <param name="elements">the matrix elements in row-major order</param>
+	/// <returns></returns>
+	template <class W>
+	node::weightednode<W> qubit_node(int depth, const std::array<node::weightednode<W>, 4>& elements) {
+		auto&& rows = node::succ_ls<W>(2);
+		for (int r = 0; r < 2; r++) {
+			rows[r] = wnode::normalize<W>(weight::ones<W>({}), depth + 1,
+				node::succ_ls<W>{ elements[2 * r], elements[2 * r + 1] });
+		}
+		return wnode::normalize<W>(weight::ones<W>({}), depth, std::move(rows));
+	}
+
+	/// <summary>
+	/// Return the weighted node of the single qubit matrix at the given depth.
+	/// </summary>
+	template <class W>
+	inline node::weightednode<W> matrix_node(int depth, const std::array<W, 4>& u) {
+		return qubit_node<W>(depth, { terminal(u[0]), terminal(u[1]), terminal(u[2]), terminal(u[3]) });
+	}
+
+	/// <summary>
+	/// Return the tdd of the single qubit gate.
+	/// </summary>
+	/// <param name="u">the matrix in row-major order</param>
+	/// <returns></returns>
+	template <class W>
+	tdd::TDD<W> gate(const std::array<W, 4>& u) {
+		return tdd::TDD<W>::from_wnode(matrix_node<W>(0, u), { 2, 2 }, gate_storage_order(1));
+	}
+
+	/// <summary>
+	/// Return the tdd of the controlled gate. The qubits 0, ..., num_controls-1 are the controls, and the last qubit is the target.
+	/// </summary>
+	/// <param name="u">the matrix of the target in row-major order</param>
+	/// <param name="num_controls"></param>
+	/// <returns></returns>
+	template <class W>
+	tdd::TDD<W> controlled(const std::array<W, 4>& u, int num_controls) {
+		auto&& zero = terminal(weight::zeros<W>({}));
+		auto&& one = weight::ones<W>({});
+		int depth = 2 * num_controls;
+		// active: the controls above are all 1, idle: the identity
+		auto&& active = matrix_node<W>(depth, u);
+		auto&& idle = matrix_node<W>(depth, { one, weight::zeros<W>({}), weight::zeros<W>({}), one });
+		for (int k = num_controls - 1; k >= 0; k--) {
+			depth = 2 * k;
+			active = qubit_node<W>(depth, { idle, zero, zero, active });
+			idle = qubit_node<W>(depth, { idle, zero, zero, idle });
+		}
+		std::vector<int64_t> data_shape(2 * (num_controls + 1), 2);
+		return tdd::TDD<W>::from_wnode(std::move(active), data_shape, gate_storage_order(num_controls + 1));
+	}
+
+	/// <summary>
+	/// Return the tdd of the identity on num_qubits qubits.
+	/// </summary>
+	template <class W>
+	tdd::TDD<W> identity(int num_qubits) {
+		if (num_qubits < 1) {
+			throw std::invalid_argument("the identity should act on at least one qubit.");
+		}
+		auto&& zero = terminal(weight::zeros<W>({}));
+		auto&& idle = terminal(weight::ones<W>({}));
+		for (int k = num_qubits - 1; k >= 0; k--) {
+			idle = qubit_node<W>(2 * k, { idle, zero, zero, idle });
+		}
+		std::vector<int64_t> data_shape(2 * num_qubits, 2);
+		return tdd::TDD<W>::from_wnode(std::move(idle), data_shape, gate_storage_order(num_qubits));
+	}
+
+	/// <summary>
+	/// Return the tdd of the SWAP gate.
+	/// </summary>
+	template <class W>
+	tdd::TDD<W> swap() {
+		auto&& one = weight::ones<W>({});
+		auto&& zero = weight::zeros<W>({});
+		// the element (r0, c0) is |c0><r0| on qubit 1
+		std::array<node::weightednode<W>, 4> elements;
+		for (int r0 = 0; r0 < 2; r0++) {
+			for (int c0 = 0; c0 < 2; c0++) {
+				std::array<W, 4> u{ zero, zero, zero, zero };
+				u[2 * c0 + r0] = one;
+				elements[2 * r0 + c0] = matrix_node<W>(2, u);
+			}
+		}
+		return tdd::TDD<W>::from_wnode(qubit_node<W>(0, elements), { 2, 2, 2, 2 }, gate_storage_order(2));
+	}
+
+	template <class W>
+	node::weightednode<W> diagonal_iterate(const std::vector<W>& diag, int num_qubits, int qubit, int64_t offset) {
+		if (qubit == num_qubits) {
+			return terminal(diag[offset]);
+		}
+		auto&& zero = terminal(weight::zeros<W>({}));
+		auto&& sub0 = diagonal_iterate<W>(diag, num_qubits, qubit + 1, 2 * offset);
+		auto&& sub1 = diagonal_iterate<W>(diag, num_qubits, qubit + 1, 2 * offset + 1);
+		return qubit_node<W>(2 * qubit, { sub0, zero, zero, sub1 });
+	}
+
+	/// <summary>
+	/// Return the tdd of the diagonal gate.
+	/// </summary>
+	/// <param name="diag">the diagonal of 2^n elements, with qubit 0 as the most significant bit</param>
+	/// <returns></returns>
+	template <class W>
+	tdd::TDD<W> diagonal(const std::vector<W>& diag) {
+		int num_qubits = 0;
+		while (((int64_t)1 << num_qubits) < diag.size()) {
+			num_qubits++;
+		}
+		if (((int64_t)1 << num_qubits) != diag.size()) {
+			throw std::invalid_argument("the length of the diagonal should be a power of 2.");
+		}
+		std::vector<int64_t> data_shape(2 * num_qubits, 2);
+		return tdd::TDD<W>::from_wnode(diagonal_iterate<W>(diag, num_qubits, 0, 0), data_shape, gate_storage_order(num_qubits));
+	}
+
+	/// <summary>
+	/// Return the single qubit matrix in row-major order.
+	/// </summary>
+	inline std::array<wcomplex, 4> matrix(const wcomplex& u00, const wcomplex& u01, const wcomplex& u10, const wcomplex& u11) {
+		return { u00, u01, u10, u11 };
+	}
+
+	/// <summary>
+	/// Return exp(i*theta).
+	/// </summary>
+	inline wcomplex e_i_theta(double theta) {
+		return wcomplex(std::cos(theta), std::sin(theta));
+	}
+
+	inline tdd::TDD<wcomplex> pauli_x() {
+		return gate(matrix(0., 1., 1., 0.));
+	}
+
+	inline tdd::TDD<wcomplex> pauli_y() {
+		return gate(matrix(0., wcomplex(0., -1.), wcomplex(0., 1.), 0.));
+	}
+
+	inline tdd::TDD<wcomplex> pauli_z() {
+		return gate(matrix(1., 0., 0., -1.));
+	}
+
+	inline tdd::TDD<wcomplex> hadamard() {
+		const double r = 1. / std::sqrt(2.);
+		return gate(matrix(r, r, r, -r));
+	}
+
+	/// <summary>
+	/// Return the phase gate diag(1, exp(i*theta)).
+	/// </summary>
+	inline tdd::TDD<wcomplex> phase(double theta) {
+		return gate(matrix(1., 0., 0., e_i_theta(theta)));
+	}
+
+	inline tdd::TDD<wcomplex> s() {
+		return gate(matrix(1., 0., 0., wcomplex(0., 1.)));
+	}
+
+	inline tdd::TDD<wcomplex> t() {
+		return phase(std::atan(1.));
+	}
+
+	inline tdd::TDD<wcomplex> rx(double theta) {
+		wcomplex c(std::cos(theta / 2), 0.);
+		wcomplex s(0., -std::sin(theta / 2));
+		return gate(matrix(c, s, s, c));
+	}
+
+	inline tdd::TDD<wcomplex> ry(double theta) {
+		wcomplex c(std::cos(theta / 2), 0.);
+		wcomplex s(std::sin(theta / 2), 0.);
+		return gate(matrix(c, -s, s, c));
+	}
+
+	inline tdd::TDD<wcomplex> rz(double theta) {
+		return gate(matrix(e_i_theta(-theta / 2), 0., 0., e_i_theta(theta / 2)));
+	}
+}
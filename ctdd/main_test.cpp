@@ -1,4 +1,7 @@
 #include "tdd.hpp"
+#include "gates.hpp"
+#include "circuit.hpp"
+#include "async.hpp"
 #include "manage.hpp"
 #include <time.h>
 #include "ThreadPool.h"
@@ -56,6 +59,77 @@ int main() {
 	std::cout << t1_indexed << endl;
 	std::cout << t1_indexed_tdd.CUDAcpl() << endl;
 
+	// gates constructed without dense tensors
+	compare(gates::hadamard().CUDAcpl(), hadamard);
+	compare(gates::controlled(gates::matrix(0., 1., 1., 0.), 1).CUDAcpl(), cnot);
+	compare(gates::diagonal<wcomplex>({ 1., 1., 1., -1. }).CUDAcpl(), cz);
+
+	// whole circuits simulated in C++
+	compare(circuit::simulate<wcomplex>(1, { circuit::named("h", { 0 }), circuit::named("h", { 0 }) }).CUDAcpl(), I);
+	compare(circuit::simulate<wcomplex>(2, { circuit::named("cx", { 0, 1 }) }).CUDAcpl(), cnot);
+	auto&& bell = torch::tensor({ 1., 0., 0., 0., 0., 0., 1., 0. }, CUDAcpl::tensor_opt).reshape({ 2,2,2 }) / sqrt(2);
+	compare(circuit::simulate<wcomplex>(2, { circuit::named("h", { 1 }), circuit::named("cx", { 1, 0 }) }, true).CUDAcpl(), bell);
+
+	// tensor weights (calculated on the native complex dtype in the Inner_native configuration)
+	auto&& ta = torch::rand({ 3,2,4,2 }, CUDAcpl::tensor_opt);
+	auto&& tb = torch::rand({ 3,4,2,2 }, CUDAcpl::tensor_opt);
+	auto&& ta_tdd = TDD<CUDAcpl::Tensor>::as_tensor(ta, 1, {});
+	auto&& tb_tdd = TDD<CUDAcpl::Tensor>::as_tensor(tb, 1, {});
+	compare(tensordot_num(ta_tdd, tb_tdd, 1).CUDAcpl(), CUDAcpl::einsum("iak,ikj->iaj", { ta, tb }));
+	compare(ta_tdd.conj().CUDAcpl(), CUDAcpl::conj(ta));
+	auto&& ta_i = torch::stack({ -ta.select(3, 1), ta.select(3, 0) }, 3);
+	compare((ta_tdd * wcomplex(0., 1.)).CUDAcpl(), ta_i);
+
+	// exact weights: H*H = I
+	auto&& h = weight::qomega::sqrt2_inv();
+	auto h_tdd = TDD<weight::qomega>::as_values({ h, h, h, -h }, { 2,2 });
+	auto hh_tdd = tensordot_num(h_tdd, h_tdd, 1);
+	compare(hh_tdd.CUDAcpl(), I);
+
+	// exact weights: H*T^4*H = X, checked for equality
+	auto&& t_tdd = TDD<weight::qomega>::as_values({ 1, 0, 0, weight::qomega::omega(1) }, { 2,2 });
+	auto htttth_tdd = tensordot_num(h_tdd, t_tdd, 1);
+	for (int i = 0; i < 3; i++) {
+		htttth_tdd = tensordot_num(htttth_tdd, t_tdd, 1);
+	}
+	htttth_tdd = tensordot_num(htttth_tdd, h_tdd, 1);
+	auto&& x_tdd = TDD<weight::qomega>::as_values({ 0, 1, 1, 0 }, { 2,2 });
+	std::cout << (htttth_tdd.w_node().get_node() == x_tdd.w_node().get_node()
+		&& htttth_tdd.w_node().weight == x_tdd.w_node().weight ? "passed" : "not passed")
+		<< ", exact Clifford+T identity" << std::endl;
+
+	// exact weights: the overflow of the denominators propagates out of the contraction
+	auto&& tiny = weight::qomega({ 1, 0, 0, 0 }, (int64_t)1 << 40);
+	auto&& tiny_tdd = TDD<weight::qomega>::as_values({ tiny, tiny }, { 2 });
+	bool overflow_thrown = false;
+	try {
+		tensordot_num(tiny_tdd, tiny_tdd, 1);
+	}
+	catch (const std::overflow_error&) {
+		overflow_thrown = true;
+	}
+	std::cout << (overflow_thrown ? "passed" : "not passed") << ", exact weight overflow" << std::endl;
+
+	// weights differing by less than EPS but straddling a bucket boundary land in the same node
+	typedef wcomplex::value_type real;
+	auto&& edge = (real)((std::round(0.3 / weight::EPS) + 0.5) * weight::EPS);
+	auto&& below = TDD<wcomplex>::as_values({ 1., std::nextafter(edge, (real)0.) }, { 2 });
+	auto&& above = TDD<wcomplex>::as_values({ 1., std::nextafter(edge, (real)1.) }, { 2 });
+	std::cout << (below.w_node().get_node() == above.w_node().get_node() ? "passed" : "not passed")
+		<< ", bucket boundary merge" << std::endl;
+
+	// the same for the weights differing by the accumulated noise (1E-12) across the boundary
+	auto&& noisy_below = TDD<wcomplex>::as_values({ 1., (real)(edge - 5E-13) }, { 2 });
+	auto&& noisy_above = TDD<wcomplex>::as_values({ 1., (real)(edge + 5E-13) }, { 2 });
+	std::cout << (noisy_below.w_node().get_node() == noisy_above.w_node().get_node() ? "passed" : "not passed")
+		<< ", bucket boundary merge with noise" << std::endl;
+
+	// asynchronous contraction on the dispatcher thread
+	auto&& h_gate = gates::hadamard();
+	auto&& hh_future = async_ops::tensordot<wcomplex, wcomplex>(h_gate, h_gate, { 1 }, { 0 });
+	compare(hh_future.get()->CUDAcpl(), I);
+
+	delete mng::p_async_pool;
 	delete wnode::iter_para::p_thread_pool;
 	return 0;
 }
\ No newline at end of file
@@ -7,3 +7,9 @@ HANDLE mng::current_process;
 #endif
 
 std::atomic<std::chrono::duration<double>> mng::garbage_check_period{ std::chrono::duration<double> {DEFAULT_MEM_CHECK_PERIOD} };
+
+std::recursive_mutex mng::engine_mutex;
+
+ThreadPool* mng::p_async_pool = nullptr;
+
+std::atomic<int> mng::stack_cont_depth{ DEFAULT_STACK_CONT_DEPTH };
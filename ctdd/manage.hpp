@@ -52,8 +52,12 @@ namespace mng {
 		cache::clean_garbage(cache::Global_Cache<CUDAcpl::Tensor>::trace_cache);
 		cache::clean_garbage(cache::Cont_Cache<CUDAcpl::Tensor, wcomplex>::cont_cache);
 		cache::clean_garbage(cache::Cont_Cache<CUDAcpl::Tensor, CUDAcpl::Tensor>::cont_cache);
+		cache::clean_garbage(cache::Global_Cache<weight::qomega>::sum_cache);
+		cache::clean_garbage(cache::Global_Cache<weight::qomega>::trace_cache);
+		cache::clean_garbage(cache::Cont_Cache<weight::qomega, weight::qomega>::cont_cache);
 		node::Node<wcomplex>::clean_garbage();
 		node::Node<CUDAcpl::Tensor>::clean_garbage();
+		node::Node<weight::qomega>::clean_garbage();
 	}
 
 	inline void clear_cache() {
@@ -100,6 +104,23 @@ namespace mng {
 		cache::Cont_Cache<CUDAcpl::Tensor, CUDAcpl::Tensor>::cont_cache.first.lock();
 		cache::Cont_Cache<CUDAcpl::Tensor, CUDAcpl::Tensor>::cont_cache.second.clear();
 		cache::Cont_Cache<CUDAcpl::Tensor, CUDAcpl::Tensor>::cont_cache.first.unlock();
+
+		// weight::qomega
+		cache::Global_Cache<weight::qomega>::CUDAcpl_cache.first.lock();
+		cache::Global_Cache<weight::qomega>::CUDAcpl_cache.second.clear();
+		cache::Global_Cache<weight::qomega>::CUDAcpl_cache.first.unlock();
+
+		cache::Global_Cache<weight::qomega>::sum_cache.first.lock();
+		cache::Global_Cache<weight::qomega>::sum_cache.second.clear();
+		cache::Global_Cache<weight::qomega>::sum_cache.first.unlock();
+
+		cache::Global_Cache<weight::qomega>::trace_cache.first.lock();
+		cache::Global_Cache<weight::qomega>::trace_cache.second.clear();
+		cache::Global_Cache<weight::qomega>::trace_cache.first.unlock();
+
+		cache::Cont_Cache<weight::qomega, weight::qomega>::cont_cache.first.lock();
+		cache::Cont_Cache<weight::qomega, weight::qomega>::cont_cache.second.clear();
+		cache::Cont_Cache<weight::qomega, weight::qomega>::cont_cache.first.unlock();
 	}
 
 
@@ -112,6 +133,20 @@ namespace mng {
 
 	extern std::atomic<std::chrono::duration<double>> garbage_check_period;
 
+	/// <summary>
+	/// The lock of the whole engine, held by the entries of the python interface, so that the callers of different threads
+	/// (with the GIL released) run one at a time. It is recursive, for the progress callback of a running operation
+	/// may enter the interface again on the same thread.
+	/// </summary>
+	extern std::recursive_mutex engine_mutex;
+
+	/// <summary>
+	/// The dispatcher of the asynchronous operations (see async.hpp), of a single thread, for the operations are serialized
+	/// by the engine lock anyway. It is separated from the thread pool of the engine, so that the waiting operations never
+	/// occupy the workers needed by the running one.
+	/// </summary>
+	extern ThreadPool* p_async_pool;
+
 	inline void get_current_process() {
 #ifdef __WIN__
 		current_process = OpenProcess(PROCESS_ALL_ACCESS, FALSE, _getpid());
@@ -205,6 +240,7 @@ namespace mng {
 		// reset the system first.
 		tdd::TDD<wcomplex>::reset();
 		tdd::TDD<CUDAcpl::Tensor>::reset();
+		tdd::TDD<weight::qomega>::reset();
 		clear_garbage();
 		clear_cache();
 
@@ -215,6 +251,11 @@ namespace mng {
 		delete wnode::iter_para::p_thread_pool;
 		wnode::iter_para::p_thread_pool = new ThreadPool(thread_num);
 
+		// the dispatcher is kept through resets, with the operations pending
+		if (!p_async_pool) {
+			p_async_pool = new ThreadPool(1);
+		}
+
 		CUDAcpl::reset(device_cuda, double_type);
 		weight::EPS = new_eps;
 	}
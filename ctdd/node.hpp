@@ -1,13 +1,10 @@
 #pragma once
 #include "stdafx.h"
 #include "cache.hpp"
+#include "control.hpp"
 
 namespace node {
 
-	template <class W>
-	using succ_ls = std::vector<weightednode<W>>;
-
-
 	// The node used in tdd.
 	template <typename W>
 	class Node {
@@ -273,12 +270,57 @@ namespace node {
 			return *this;
 		}
 
+		/// <summary>
+		/// Look up the keys with the weight codes moved to the adjacent quantization buckets, for the weights lying near
+		/// the bucket boundaries. So weights equal within tolerance but rounded differently still merge into one node.
+		/// Only scalar weights are probed. (unique_table_m should be locked)
+		/// </summary>
+		/// <param name="key">the key missed</param>
+		/// <param name="successors"></param>
+		/// <returns></returns>
+		static typename cache::unique_table<W>::iterator probe_neighbors(const cache::unique_table_key<W>& key,
+			const succ_ls<W>& successors) {
+			if constexpr (std::is_same_v<W, wcomplex>) {
+				// (code vector, position, direction) of the codes near the boundaries
+				std::vector<std::tuple<bool, int, int>> boundary_codes;
+				for (int i = 0; i < successors.size() && boundary_codes.size() < MAX_PROBE_CODES; i++) {
+					auto dir_real = weight::boundary_direction(successors[i].weight.real());
+					if (dir_real) {
+						boundary_codes.push_back(std::make_tuple(true, i, dir_real));
+					}
+					auto dir_imag = weight::boundary_direction(successors[i].weight.imag());
+					if (dir_imag && boundary_codes.size() < MAX_PROBE_CODES) {
+						boundary_codes.push_back(std::make_tuple(false, i, dir_imag));
+					}
+				}
+
+				for (int mask = 1; mask < (1 << boundary_codes.size()); mask++) {
+					cache::unique_table_key<W> probe{ key };
+					for (int j = 0; j < boundary_codes.size(); j++) {
+						if (mask & (1 << j)) {
+							auto&& code = std::get<0>(boundary_codes[j]) ? probe.code1 : probe.code2;
+							code[std::get<1>(boundary_codes[j])] += std::get<2>(boundary_codes[j]);
+						}
+					}
+					probe.hash = probe.calculate_hash();
+					auto&& p_find_res = Node<W>::m_unique_table.find(probe);
+					if (p_find_res != Node<W>::m_unique_table.end()) {
+						return p_find_res;
+					}
+				}
+			}
+			return Node<W>::m_unique_table.end();
+		}
+
 		static weightednode<W> get_wnode(W&& wei, int order, succ_ls<W>&& successors) {
 			auto&& key = cache::unique_table_key<W>(order, successors);
 
 			//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 			Node<W>::unique_table_m.lock();
 			auto&& p_find_res = Node<W>::m_unique_table.find(key);
+			if (p_find_res == Node<W>::m_unique_table.end()) {
+				p_find_res = probe_neighbors(key, successors);
+			}
 
 			if (p_find_res != Node<W>::m_unique_table.end()) {
 				// and another reference
@@ -295,6 +337,7 @@ namespace node {
 
 			// a node of reference 1 is created.
 			node::Node<W>* p_node = new node::Node<W>(order, std::move(successors));
+			ctrl::count_node();
 
 			Node<W>::m_unique_table[key] = p_node;
 			Node<W>::unique_table_m.unlock();
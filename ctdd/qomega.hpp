@@ -0,0 +1,257 @@
+#pragma once
+#include "stdafx.h"
+
+namespace weight {
+
+	/// <summary>
+	/// The overflow-checked integer arithmetic for the exact weights.
+	/// </summary>
+	namespace exact {
+		inline int64_t add(int64_t a, int64_t b) {
+			if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {
+				throw std::overflow_error("the exact weight exceeds the range of int64.");
+			}
+			return a + b;
+		}
+
+		inline int64_t mul(int64_t a, int64_t b) {
+			if (a == 0 || b == 0) {
+				return 0;
+			}
+			bool overflow;
+			if (a > 0) {
+				overflow = b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a;
+			}
+			else {
+				overflow = b > 0 ? a < INT64_MIN / b : b < INT64_MAX / a;
+			}
+			if (overflow) {
+				throw std::overflow_error("the exact weight exceeds the range of int64.");
+			}
+			return a * b;
+		}
+	}
+
+	/// <summary>
+	/// The exact weight in the cyclotomic field Q(omega), omega = exp(i*pi/4), stored as
+	///		(c[0] + c[1]*omega + c[2]*omega^2 + c[3]*omega^3) / den,
+	/// with den > 0 and the common divisor of all the integers reduced to 1, so that every number has one representation.
+	/// The entries of Clifford+T gates are covered (e.g. sqrt(2) = omega - omega^3), and the arithmetic, equality and hashing
+	/// are exact. std::overflow_error is thrown if the integers exceed int64.
+	/// </summary>
+	class qomega {
+	private:
+		std::array<int64_t, 4> m_c;
+		int64_t m_den;
+
+	private:
+		void reduce() {
+			if (m_den == 0) {
+				throw std::domain_error("the denominator of an exact weight is zero.");
+			}
+			if (m_den < 0) {
+				for (auto& c : m_c) {
+					c = -c;
+				}
+				m_den = -m_den;
+			}
+			auto g = m_den;
+			for (const auto& c : m_c) {
+				g = std::gcd(g, c);
+			}
+			for (auto& c : m_c) {
+				c /= g;
+			}
+			m_den /= g;
+		}
+
+		/// <summary>
+		/// The sign of the real number (c0 + c1*sqrt(2)).
+		/// </summary>
+		static int sign_sqrt2(int64_t c0, int64_t c1) {
+			auto s0 = (c0 > 0) - (c0 < 0);
+			auto s1 = (c1 > 0) - (c1 < 0);
+			if (s0 == s1 || s1 == 0) {
+				return s0;
+			}
+			if (s0 == 0) {
+				return s1;
+			}
+			// compare c0^2 and 2*c1^2
+			auto sq0 = exact::mul(c0, c0);
+			auto sq1 = exact::mul(2, exact::mul(c1, c1));
+			return sq0 > sq1 ? s0 : s1;
+		}
+
+	public:
+		qomega() noexcept : m_c{ 0, 0, 0, 0 }, m_den(1) {}
+
+		qomega(int64_t n) noexcept : m_c{ n, 0, 0, 0 }, m_den(1) {}
+
+		qomega(const std::array<int64_t, 4>& c, int64_t den = 1) : m_c(c), m_den(den) {
+			reduce();
+		}
+
+		/// <summary>
+		/// Return omega^k.
+		/// </summary>
+		static qomega omega(int k) {
+			k = ((k % 8) + 8) % 8;
+			std::array<int64_t, 4> c{ 0, 0, 0, 0 };
+			c[k % 4] = k < 4 ? 1 : -1;
+			return qomega(c);
+		}
+
+		/// <summary>
+		/// Return 1/sqrt(2) = (omega - omega^3) / 2.
+		/// </summary>
+		static qomega sqrt2_inv() {
+			return qomega({ 0, 1, 0, -1 }, 2);
+		}
+
+		inline const std::array<int64_t, 4>& coefficients() const noexcept {
+			return m_c;
+		}
+
+		inline int64_t denominator() const noexcept {
+			return m_den;
+		}
+
+		inline bool is_zero() const noexcept {
+			return m_c[0] == 0 && m_c[1] == 0 && m_c[2] == 0 && m_c[3] == 0;
+		}
+
+		/// <summary>
+		/// The numerical value.
+		/// </summary>
+		wcomplex value() const noexcept {
+			const double r = 1. / std::sqrt(2.);
+			double re = m_c[0] + (m_c[1] - m_c[3]) * r;
+			double im = m_c[2] + (m_c[1] + m_c[3]) * r;
+			return wcomplex(re / m_den, im / m_den);
+		}
+
+		/// <summary>
+		/// The image under the Galois automorphism omega -> omega^k (k odd).
+		/// </summary>
+		qomega galois(int k) const {
+			std::array<int64_t, 4> c{ 0, 0, 0, 0 };
+			for (int j = 0; j < 4; j++) {
+				auto power = (j * k) % 8;
+				if (power < 4) {
+					c[power] = exact::add(c[power], m_c[j]);
+				}
+				else {
+					c[power - 4] = exact::add(c[power - 4], -m_c[j]);
+				}
+			}
+			return qomega(c, m_den);
+		}
+
+		/// <summary>
+		/// The complex conjugate (omega -> omega^7).
+		/// </summary>
+		inline qomega conj() const {
+			return galois(7);
+		}
+
+		/// <summary>
+		/// The exact squared magnitude, which lies in Q(sqrt(2)).
+		/// </summary>
+		inline qomega norm() const {
+			return *this * conj();
+		}
+
+		/// <summary>
+		/// Compare the magnitudes exactly. Return -1, 0 or 1.
+		/// </summary>
+		static int compare_magnitude(const qomega& a, const qomega& b) {
+			// a real number in Q(omega) is (c0 + c1*sqrt(2)) / den
+			auto&& diff = a.norm() - b.norm();
+			return sign_sqrt2(diff.m_c[0], diff.m_c[1]);
+		}
+
+		/// <summary>
+		/// The multiplicative inverse, calculated with the product of the other Galois conjugates.
+		/// </summary>
+		qomega inverse() const {
+			if (is_zero()) {
+				throw std::domain_error("the exact weight zero is not invertible.");
+			}
+			auto&& others = galois(3) * galois(5) * galois(7);
+			// the field norm is rational
+			auto&& field_norm = *this * others;
+			return others * qomega({ field_norm.m_den, 0, 0, 0 }, field_norm.m_c[0]);
+		}
+
+		friend qomega operator +(const qomega& a, const qomega& b) {
+			auto g = std::gcd(a.m_den, b.m_den);
+			auto fa = b.m_den / g;
+			auto fb = a.m_den / g;
+			std::array<int64_t, 4> c;
+			for (int i = 0; i < 4; i++) {
+				c[i] = exact::add(exact::mul(a.m_c[i], fa), exact::mul(b.m_c[i], fb));
+			}
+			return qomega(c, exact::mul(a.m_den, fa));
+		}
+
+		friend qomega operator -(const qomega& a) {
+			qomega res{ a };
+			for (auto& c : res.m_c) {
+				c = -c;
+			}
+			return res;
+		}
+
+		friend qomega operator -(const qomega& a, const qomega& b) {
+			return a + (-b);
+		}
+
+		friend qomega operator *(const qomega& a, const qomega& b) {
+			// omega^4 = -1
+			std::array<int64_t, 4> c{ 0, 0, 0, 0 };
+			for (int i = 0; i < 4; i++) {
+				for (int j = 0; j < 4; j++) {
+					auto&& term = exact::mul(a.m_c[i], b.m_c[j]);
+					if (i + j < 4) {
+						c[i + j] = exact::add(c[i + j], term);
+					}
+					else {
+						c[i + j - 4] = exact::add(c[i + j - 4], -term);
+					}
+				}
+			}
+			return qomega(c, exact::mul(a.m_den, b.m_den));
+		}
+
+		friend qomega operator /(const qomega& a, const qomega& b) {
+			return a * b.inverse();
+		}
+
+		friend bool operator ==(const qomega& a, const qomega& b) noexcept {
+			return a.m_den == b.m_den && a.m_c == b.m_c;
+		}
+
+		friend bool operator !=(const qomega& a, const qomega& b) noexcept {
+			return !(a == b);
+		}
+
+		friend std::ostream& operator <<(std::ostream& out, const qomega& a) {
+			out << "(" << a.m_c[0] << " + " << a.m_c[1] << "w + " << a.m_c[2] << "w^2 + " << a.m_c[3] << "w^3)/" << a.m_den;
+			return out;
+		}
+	};
+
+	inline qomega conj(const qomega& a) {
+		return a.conj();
+	}
+
+	inline std::size_t hash_value(const qomega& a) noexcept {
+		std::size_t seed = 0;
+		for (const auto& c : a.coefficients()) {
+			boost::hash_combine(seed, c);
+		}
+		boost::hash_combine(seed, a.denominator());
+		return seed;
+	}
+}
@@ -13,11 +13,16 @@
 #include <complex>
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/container_hash/hash_fwd.hpp>
 #include <string>
 #include <algorithm>
 #include <type_traits>
 #include <vector>
+#include <array>
+#include <variant>
+#include <numeric>
+#include <random>
 #include <assert.h>
 #include <chrono>
 
@@ -47,6 +52,7 @@
 
 // multi-thread
 #include <shared_mutex>
+#include <mutex>
 #include <atomic>
 #include "ThreadPool.h"
 
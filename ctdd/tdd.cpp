@@ -10,6 +10,9 @@ boost::unordered_set<tdd::TDD<wcomplex>*> tdd::TDD<wcomplex>::m_all_tdds{};
 template <>
 boost::unordered_set<tdd::TDD<CUDAcpl::Tensor>*> tdd::TDD<CUDAcpl::Tensor>::m_all_tdds{};
 
+template <>
+boost::unordered_set<tdd::TDD<weight::qomega>*> tdd::TDD<weight::qomega>::m_all_tdds{};
+
 template <>
 cache::unique_table<wcomplex> node::Node<wcomplex>::m_unique_table{};
 
@@ -21,6 +24,11 @@ cache::unique_table<CUDAcpl::Tensor> node::Node<CUDAcpl::Tensor>::m_unique_table
 template <>
 std::shared_mutex node::Node<CUDAcpl::Tensor>::unique_table_m{};
 
+template <>
+cache::unique_table<weight::qomega> node::Node<weight::qomega>::m_unique_table{};
+template <>
+std::shared_mutex node::Node<weight::qomega>::unique_table_m{};
+
 template <>
 std::pair<std::shared_mutex, cache::CUDAcpl_table<wcomplex>> cache::Global_Cache<wcomplex>::CUDAcpl_cache{};
 template <>
@@ -35,6 +43,13 @@ std::pair<std::shared_mutex, cache::sum_table<CUDAcpl::Tensor>> cache::Global_Ca
 template <>
 std::pair<std::shared_mutex, cache::trace_table<CUDAcpl::Tensor>> cache::Global_Cache<CUDAcpl::Tensor>::trace_cache{};
 
+template <>
+std::pair<std::shared_mutex, cache::CUDAcpl_table<weight::qomega>> cache::Global_Cache<weight::qomega>::CUDAcpl_cache{};
+template <>
+std::pair<std::shared_mutex, cache::sum_table<weight::qomega>> cache::Global_Cache<weight::qomega>::sum_cache{};
+template <>
+std::pair<std::shared_mutex, cache::trace_table<weight::qomega>> cache::Global_Cache<weight::qomega>::trace_cache{};
+
 
 template <>
 std::pair<std::shared_mutex, cache::cont_table<wcomplex, wcomplex>> cache::Cont_Cache<wcomplex, wcomplex>::cont_cache{};
@@ -44,6 +59,10 @@ template <>
 std::pair<std::shared_mutex, cache::cont_table<CUDAcpl::Tensor, wcomplex>> cache::Cont_Cache<CUDAcpl::Tensor, wcomplex>::cont_cache{};
 template <>
 std::pair<std::shared_mutex, cache::cont_table<CUDAcpl::Tensor, CUDAcpl::Tensor>> cache::Cont_Cache<CUDAcpl::Tensor, CUDAcpl::Tensor>::cont_cache{};
+template <>
+std::pair<std::shared_mutex, cache::cont_table<weight::qomega, weight::qomega>> cache::Cont_Cache<weight::qomega, weight::qomega>::cont_cache{};
+
+thread_local ctrl::Controller* ctrl::p_current = nullptr;
 
 ThreadPool* wnode::iter_para::p_thread_pool = new ThreadPool(DEFAULT_THREAD_NUM);
 
@@ -56,6 +75,8 @@ wnode::iter_para::para_coordinator<CUDAcpl::Tensor, wcomplex> wnode::iter_para::
 template <>
 wnode::iter_para::para_coordinator<CUDAcpl::Tensor, CUDAcpl::Tensor> wnode::iter_para::Para_Crd<CUDAcpl::Tensor, CUDAcpl::Tensor>::record = wnode::iter_para::para_coordinator<CUDAcpl::Tensor, CUDAcpl::Tensor>();
 template <>
+wnode::iter_para::para_coordinator<weight::qomega, weight::qomega> wnode::iter_para::Para_Crd<weight::qomega, weight::qomega>::record = wnode::iter_para::para_coordinator<weight::qomega, weight::qomega>();
+template <>
 shared_mutex wnode::iter_para::Para_Crd<wcomplex, wcomplex>::m{};
 template <>
 shared_mutex wnode::iter_para::Para_Crd<wcomplex, CUDAcpl::Tensor>::m{};
@@ -63,5 +84,7 @@ template <>
 shared_mutex wnode::iter_para::Para_Crd<CUDAcpl::Tensor, wcomplex>::m{};
 template <>
 shared_mutex wnode::iter_para::Para_Crd<CUDAcpl::Tensor, CUDAcpl::Tensor>::m{};
+template <>
+shared_mutex wnode::iter_para::Para_Crd<weight::qomega, weight::qomega>::m{};
 
 c10::TensorOptions CUDAcpl::tensor_opt = c10::TensorOptions();
\ No newline at end of file
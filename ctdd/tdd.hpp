@@ -220,6 +220,14 @@ namespace tdd {
 			return m_storage_order;
 		}
 
+		inline const std::vector<int64_t>& inversed_order() const noexcept {
+			return m_inversed_order;
+		}
+
+		inline const std::vector<int64_t>& inner_data_shape() const noexcept {
+			return m_inner_data_shape;
+		}
+
 		inline int size() const noexcept {
 			if (m_wnode.get_node() == nullptr) {
 				return 0;
@@ -286,8 +294,11 @@ namespace tdd {
 		/// <param name="storage_order">The index order used to stor this representation.
 		/// Note that the item count + dim_parallel should be the dim of t strictly.
 		/// If empty order is put in, the trival order will be taken.</param>
+		/// <param name="p_ctrl">The controller of this operation. nullptr for no control.</param>
 		/// <returns>The tdd created.</returns>
-		static TDD<W> as_tensor(const CUDAcpl::Tensor& t, int dim_parallel, const std::vector<int64_t>& storage_order) {
+		static TDD<W> as_tensor(const CUDAcpl::Tensor& t, int dim_parallel, const std::vector<int64_t>& storage_order,
+			ctrl::Controller* p_ctrl = nullptr) {
+			ctrl::Scope scope{ p_ctrl };
 
 			auto&& dim_total = t.dim() - 1;
 			auto&& dim_data = dim_total - dim_parallel;
@@ -313,10 +324,133 @@ namespace tdd {
 			for (int i = 0; i < dim_data; i++) {
 				temp_data[i] = t.size(i + dim_parallel);
 			}
-			auto&& w_node = wnode::as_tensor_iterate<W>(t, temp_para, temp_data, storage_order_pd, 0);
+			node::weightednode<W> w_node;
+			if constexpr (std::is_same_v<W, wcomplex>) {
+				// scalar weights are built bottom-up from the buffer directly
+				w_node = wnode::as_tensor_bottom_up<W>(t, temp_data, storage_order_pd);
+			}
+			else {
+				w_node = wnode::as_tensor_iterate<W>(t, temp_para, temp_data, storage_order_pd, 0);
+			}
 			return TDD(std::move(w_node), std::move(temp_para), std::move(temp_data), std::move(storage_order_pd));
 		}
 
+		/// <summary>
+		/// Construct the tdd from the scalar values given in row-major order (without parallel indices).
+		/// It is the way to prepare tdds of exact weights (weight::qomega), which cannot be read from a tensor.
+		/// </summary>
+		/// <param name="values">the values of all elements, in row-major order</param>
+		/// <param name="data_shape"></param>
+		/// <param name="storage_order"></param>
+		/// <returns></returns>
+		static TDD<W> as_values(const std::vector<W>& values, const std::vector<int64_t>& data_shape,
+			const std::vector<int64_t>& storage_order = {}, ctrl::Controller* p_ctrl = nullptr) {
+			static_assert(!std::is_same_v<W, CUDAcpl::Tensor>, "as_values is for scalar weights only.");
+			ctrl::Scope scope{ p_ctrl };
+
+			std::vector<int64_t> storage_order_pd;
+			if (storage_order.empty()) {
+				storage_order_pd.resize(data_shape.size());
+				for (int i = 0; i < data_shape.size(); i++) {
+					storage_order_pd[i] = i;
+				}
+			}
+			else {
+				storage_order_pd = storage_order;
+			}
+
+			std::vector<int64_t> strides(data_shape.size());
+			int64_t stride = 1;
+			for (int i = (int)data_shape.size() - 1; i >= 0; i--) {
+				strides[i] = stride;
+				stride *= data_shape[i];
+			}
+			if (values.size() != stride) {
+				throw std::invalid_argument("the number of values does not match the data shape.");
+			}
+
+			return from_wnode(wnode::as_values_iterate<W>(values, strides, data_shape, storage_order_pd, 0, 0),
+				data_shape, storage_order_pd);
+		}
+
+		/// <summary>
+		/// Construct the tdd from the sparse tensor in the COO format (scalar weight, without parallel indices),
+		/// without materializing the dense tensor. The entries are sorted along the storage order and inserted path by path,
+		/// and the values of duplicated coordinates are summed up.
+		/// </summary>
+		/// <param name="indices">the coordinates of the entries, of shape (nnz, dim_data) in row-major order</param>
+		/// <param name="values">the values of the entries</param>
+		/// <param name="data_shape"></param>
+		/// <param name="storage_order"></param>
+		/// <returns></returns>
+		static TDD<W> as_sparse(const std::vector<int64_t>& indices, const std::vector<W>& values,
+			const std::vector<int64_t>& data_shape, const std::vector<int64_t>& storage_order = {},
+			ctrl::Controller* p_ctrl = nullptr) {
+			static_assert(!std::is_same_v<W, CUDAcpl::Tensor>, "as_sparse is for scalar weights only.");
+			ctrl::Scope scope{ p_ctrl };
+
+			int64_t dim_data = data_shape.size();
+			std::vector<int64_t> storage_order_pd;
+			if (storage_order.empty()) {
+				storage_order_pd.resize(dim_data);
+				for (int i = 0; i < dim_data; i++) {
+					storage_order_pd[i] = i;
+				}
+			}
+			else {
+				storage_order_pd = storage_order;
+			}
+
+			int64_t nnz = values.size();
+			if (indices.size() != nnz * dim_data) {
+				throw std::invalid_argument("the number of coordinates does not match the number of values.");
+			}
+			for (int64_t i = 0; i < nnz; i++) {
+				for (int64_t j = 0; j < dim_data; j++) {
+					auto&& coordinate = indices[i * dim_data + j];
+					if (coordinate < 0 || coordinate >= data_shape[j]) {
+						throw std::invalid_argument("the coordinate is out of the data shape.");
+					}
+				}
+			}
+
+			// sort the entries along the storage order
+			std::vector<int64_t> entries(nnz);
+			for (int64_t i = 0; i < nnz; i++) {
+				entries[i] = i;
+			}
+			std::sort(entries.begin(), entries.end(),
+				[&](const int64_t& a, const int64_t& b) {
+					for (const auto& pos : storage_order_pd) {
+						auto&& coordinate_a = indices[a * dim_data + pos];
+						auto&& coordinate_b = indices[b * dim_data + pos];
+						if (coordinate_a != coordinate_b) {
+							return coordinate_a < coordinate_b;
+						}
+					}
+					return false;
+				});
+
+			return from_wnode(wnode::as_sparse_iterate<W>(indices, values, entries, 0, nnz, data_shape, storage_order_pd, 0),
+				data_shape, storage_order_pd);
+		}
+
+		/// <summary>
+		/// Construct the tdd from the weighted node built directly (scalar weight, without parallel indices).
+		/// The weighted node should be normalized, with the depths of nodes following storage_order.
+		/// </summary>
+		/// <param name="w_node"></param>
+		/// <param name="data_shape">the range of each index (without the extra inner dimension)</param>
+		/// <param name="storage_order"></param>
+		/// <returns></returns>
+		static TDD<W> from_wnode(node::weightednode<W>&& w_node, const std::vector<int64_t>& data_shape,
+			const std::vector<int64_t>& storage_order) {
+			static_assert(!std::is_same_v<W, CUDAcpl::Tensor>, "from_wnode is for scalar weights only.");
+			std::vector<int64_t> temp_data(data_shape);
+			temp_data.push_back(2);
+			return TDD(std::move(w_node), std::vector<int64_t>(), std::move(temp_data), std::vector<int64_t>(storage_order));
+		}
+
 		/// <summary>
 		/// return a tensor of all elements zero, of given shape, stored in given storage order.
 		/// </summary>
@@ -390,6 +524,123 @@ namespace tdd {
 			return res;
 		}
 
+		/// <summary>
+		/// Write this tensor into the given CUDA complex tensor directly, without the intermediate tensors of CUDAcpl().
+		/// out should be on cpu, of a floating type and of the same shape as CUDAcpl(). The tensor weight version copies
+		/// the result of CUDAcpl() instead.
+		/// </summary>
+		/// <param name="out"></param>
+		void CUDAcpl_into(CUDAcpl::Tensor& out) const {
+			auto&& dim_data = m_storage_order.size();
+			std::vector<int64_t> shape(m_para_shape);
+			for (int i = 0; i < dim_data; i++) {
+				shape.push_back(m_data_shape[i]);
+			}
+			shape.push_back(2);
+			if (out.sizes() != c10::IntArrayRef(shape)) {
+				throw std::invalid_argument("the output tensor is not of the shape of the tdd.");
+			}
+
+			if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
+				out.copy_(CUDAcpl());
+			}
+			else {
+				if (out.is_cuda()) {
+					throw std::invalid_argument("the output tensor should be on cpu.");
+				}
+				auto&& out_strides = out.strides();
+				std::vector<int64_t> strides(out_strides.begin(), out_strides.end());
+
+				out.zero_();
+				if (out.scalar_type() == c10::ScalarType::Double) {
+					write_buffer(out.data_ptr<double>(), strides);
+				}
+				else if (out.scalar_type() == c10::ScalarType::Float) {
+					write_buffer(out.data_ptr<float>(), strides);
+				}
+				else {
+					throw std::invalid_argument("the output tensor should be of a floating type.");
+				}
+			}
+		}
+
+		/// <summary>
+		/// Write this tensor into the buffer of complex numbers directly (scalar weight only).
+		/// The buffer should be zero-filled, for the zero sub-tensors are skipped.
+		/// </summary>
+		/// <param name="p_data">the real part of the first element</param>
+		/// <param name="strides">the strides (in the number of T) of the data indices, and of the real/imag dimension at last</param>
+		template <typename T>
+		void write_buffer(T* p_data, const std::vector<int64_t>& strides) const {
+			static_assert(!std::is_same_v<W, CUDAcpl::Tensor>, "write_buffer is for scalar weights only.");
+			auto&& dim_data = m_storage_order.size();
+			// the buffer strides in the inner index order
+			std::vector<int64_t> inner_strides(dim_data + 1);
+			for (int i = 0; i < dim_data; i++) {
+				inner_strides[i] = strides[m_storage_order[i]];
+			}
+			inner_strides[dim_data] = strides[dim_data];
+			wnode::to_buffer_iterate<W, T>(m_wnode.get_node(), weight::numerical(m_wnode.weight), 0, p_data,
+				m_inner_data_shape, inner_strides);
+		}
+
+		/// <summary>
+		/// Draw samples of the index values, with the probability proportional to the squared magnitude of the elements
+		/// (e.g. the measurement outcomes of a state), without the dense tensor. The distributions over the successors
+		/// are calculated once on the DAG, and each sample is a random walk from the root to the terminal.
+		/// The samples are drawn in blocks across the threads, each block with its own random engine seeded from seed,
+		/// so that the result is reproducible. (scalar weight only)
+		/// </summary>
+		/// <param name="num_samples"></param>
+		/// <param name="seed"></param>
+		/// <returns>the samples of shape (num_samples, dim_data) in row-major order</returns>
+		std::vector<int64_t> sample(int64_t num_samples, uint64_t seed = 0, ctrl::Controller* p_ctrl = nullptr) const {
+			static_assert(std::is_same_v<W, wcomplex>, "sample is for scalar weights only.");
+			if (num_samples < 0) {
+				throw std::invalid_argument("the number of samples should be non-negative.");
+			}
+			ctrl::Scope scope{ p_ctrl };
+
+			auto&& distributions = wnode::sample_distributions(m_wnode, m_inner_data_shape);
+			if (weight::is_exact_zero(m_wnode.weight)
+				|| (m_wnode.get_node() != nullptr && distributions[m_wnode.get_node()].back() <= 0.)) {
+				throw std::domain_error("cannot sample from the zero tensor.");
+			}
+
+			int64_t dim_data = m_storage_order.size();
+			std::vector<int64_t> res(num_samples * dim_data);
+			const int64_t block_size = 1024;
+			// the controller is checked once every check_period samples in a block
+			const int64_t check_period = 64;
+			int64_t num_blocks = (num_samples + block_size - 1) / block_size;
+			std::vector<std::future<void>> results(num_blocks);
+			for (int64_t n = 0; n < num_blocks; n++) {
+				results[n] = wnode::iter_para::p_thread_pool->enqueue(
+					ctrl::bind([&, n] {
+						std::seed_seq seq{ (uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)n };
+						std::mt19937_64 rng(seq);
+						auto end = (std::min)(num_samples, (n + 1) * block_size);
+						for (int64_t i = n * block_size; i < end; i++) {
+							if (i % check_period == 0) {
+								ctrl::check();
+							}
+							wnode::sample_walk(m_wnode, m_inner_data_shape, distributions, m_storage_order, rng, res.data() + i * dim_data);
+						}
+					})
+				);
+			}
+
+			for (auto& result : results) {
+				while (result.wait_for(mng::garbage_check_period.load()) != std::future_status::ready) {
+					mng::cache_clear_check();
+					ctrl::poll();
+				}
+			}
+			for (auto& result : results) {
+				result.get();
+			}
+			return res;
+		}
 
 		/// <summary>
 		/// Sum up tdd a and b, and return the reduced result.
@@ -397,8 +648,10 @@ namespace tdd {
 		/// </summary>
 		/// <param name="a"></param>
 		/// <param name="b"></param>
+		/// <param name="p_ctrl">The controller of this operation. nullptr for no control.</param>
 		/// <returns></returns>
-		inline static TDD<W> sum(const TDD<W>& a, const TDD<W>& b) {
+		inline static TDD<W> sum(const TDD<W>& a, const TDD<W>& b, ctrl::Controller* p_ctrl = nullptr) {
+			ctrl::Scope scope{ p_ctrl };
 			auto&& res_wnode = wnode::sum<W>(a.m_wnode, b.m_wnode, a.m_para_shape);
 			return TDD(std::move(res_wnode),
 				std::vector<int64_t>(a.m_para_shape),
@@ -413,8 +666,10 @@ namespace tdd {
 		/// data_indices should be counted in the data indices only.
 		/// </summary>
 		/// <param name="indices"></param>
+		/// <param name="p_ctrl">The controller of this operation. nullptr for no control.</param>
 		/// <returns></returns>
-		TDD<W> trace(const cache::pair_cmd& indices) const {
+		TDD<W> trace(const cache::pair_cmd& indices, ctrl::Controller* p_ctrl = nullptr) const {
+			ctrl::Scope scope{ p_ctrl };
 			if (indices.empty()) {
 				return clone();
 			}
@@ -548,6 +803,91 @@ namespace tdd {
 				std::vector<int64_t>(m_data_shape),
 				std::vector<int64_t>(m_storage_order));
 		}
+
+		/// <summary>
+		/// Swap the inner levels (level, level + 1) in place. The tensor represented is not changed,
+		/// while the storage order is updated.
+		/// </summary>
+		/// <param name="level">counted in the inner data indices</param>
+		/// <returns>the change of the size</returns>
+		int swap_levels(int level) {
+			auto&& swap_res = wnode::swap_levels(m_wnode, m_para_shape, m_inner_data_shape, level);
+			m_wnode = std::move(swap_res.first);
+
+			std::swap(m_storage_order[level], m_storage_order[level + 1]);
+			calculate_inner_data_shape();
+			calculate_inversed_order();
+			calculate_global_order();
+			calculate_inversed_global_order();
+			return swap_res.second;
+		}
+
+		/// <summary>
+		/// Reorder the inner levels in place by sifting, to reduce the size of this tdd.
+		/// Every index is moved through all the levels by adjacent swaps and placed at the best level,
+		/// starting from the most populous level. The moving in one direction stops early if the size exceeds
+		/// max_growth times the best size. The size is followed by the changes reported by the swaps.
+		/// </summary>
+		/// <param name="max_growth"></param>
+		/// <returns>the size after sifting</returns>
+		int sift(double max_growth = DEFAULT_SIFT_MAX_GROWTH) {
+			int dim = dim_data();
+			if (dim < 2 || m_wnode.get_node() == nullptr) {
+				return size();
+			}
+
+			// sift the indices in the order of decreasing node numbers
+			auto&& level_nodes = wnode::level_statistics(m_wnode, dim).first;
+			std::vector<int64_t> labels(m_storage_order);
+			std::stable_sort(labels.begin(), labels.end(),
+				[&](const int64_t& a, const int64_t& b) {
+					return level_nodes[m_inversed_order[a]] > level_nodes[m_inversed_order[b]];
+				});
+
+			int current_size = size();
+			int best_size = current_size;
+			for (const auto& label : labels) {
+				int pos = m_inversed_order[label];
+				int best_pos = pos;
+
+				// move down
+				while (pos < dim - 1) {
+					current_size += swap_levels(pos);
+					pos++;
+					if (current_size < best_size) {
+						best_size = current_size;
+						best_pos = pos;
+					}
+					else if (current_size > max_growth * best_size) {
+						break;
+					}
+				}
+
+				// move up
+				while (pos > 0) {
+					current_size += swap_levels(pos - 1);
+					pos--;
+					if (current_size < best_size) {
+						best_size = current_size;
+						best_pos = pos;
+					}
+					else if (current_size > max_growth * best_size && pos < best_pos) {
+						break;
+					}
+				}
+
+				// settle at the best level
+				while (pos < best_pos) {
+					current_size += swap_levels(pos);
+					pos++;
+				}
+				while (pos > best_pos) {
+					current_size += swap_levels(pos - 1);
+					pos--;
+				}
+			}
+			return best_size;
+		}
 		
 		template <typename W1, typename W2>
 		friend TDD<weight::W_C<W1, W2>> operator *(const TDD<W1>& a, const W2& s);
@@ -555,13 +895,19 @@ namespace tdd {
 		template <typename W1, typename W2>
 		friend TDD<weight::W_C<W1, W2>>
 			tensordot_num(const TDD<W1>& a, const TDD<W2>& b, int num_indices,
-				const std::vector<int>& rearrangement, bool parallel_tensor);
+				const std::vector<int>& rearrangement, bool parallel_tensor, ctrl::Controller* p_ctrl);
 		
 		template <typename W1, typename W2>
 		friend TDD<weight::W_C<W1, W2>>
 			tensordot(const TDD<W1>& a, const TDD<W2>& b,
 				const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b,
-				const std::vector<int>& rearrangement, bool parallel_tensor);
+				const std::vector<int>& rearrangement, bool parallel_tensor, ctrl::Controller* p_ctrl);
+
+		template <typename W1, typename W2>
+		friend TDD<weight::W_C<W1, W2>>
+			tensordot_hsf(const TDD<W1>& a, const TDD<W2>& b,
+				const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b, double slice_budget,
+				const std::vector<int>& rearrangement, bool parallel_tensor, ctrl::Controller* p_ctrl);
 
 	};
 
@@ -587,22 +933,41 @@ namespace tdd {
 
 
 	/// <summary>
-	/// The pytorch-like tensordot method. Note that indices should be counted with data indices only.
-	/// Whether to tensor on the parallel indices.
+	/// The preparation of a contraction, shared by the execution and the estimation.
+	/// </summary>
+	struct cont_plan {
+		// list of (first, second). first: inner indices of a, second: inner indices of b
+		cache::pair_cmd inner_indices_cmd;
+
+		// the new inner order of each node in a and b
+		std::vector<int64_t> a_inner_order;
+		std::vector<int64_t> b_inner_order;
+
+		// the inner data shape of the result, including the extra inner dim (2)
+		std::vector<int64_t> total_inner_shape;
+
+		// the storage order and data shape of the result
+		std::vector<int64_t> total_order;
+		std::vector<int64_t> total_shape;
+
+		std::vector<int64_t> para_shape_res;
+	};
+
+	/// <summary>
+	/// Prepare the inner indices, orders and shapes for the tensordot of a and b.
+	/// Note that indices should be counted with data indices only.
 	/// </summary>
-	/// <typeparam name="W"></typeparam>
 	template <typename W1, typename W2>
-	TDD<weight::W_C<W1, W2>>
-		tensordot(const TDD<W1>& a, const TDD<W2>& b,
+	cont_plan tensordot_plan(const TDD<W1>& a, const TDD<W2>& b,
 		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b,
-		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false) {
+		const std::vector<int>& rearrangement, bool parallel_tensor) {
 
 		// transform to inner indices
 		cache::pair_cmd inner_indices_cmd(ils_a.size());
 		for (int i = 0; i < ils_a.size(); i++) {
 			// arrange the smaller index at the first
-			inner_indices_cmd[i].first = a.m_inversed_order[ils_a[i]];
-			inner_indices_cmd[i].second = b.m_inversed_order[ils_b[i]];
+			inner_indices_cmd[i].first = a.inversed_order()[ils_a[i]];
+			inner_indices_cmd[i].second = b.inversed_order()[ils_b[i]];
 		}
 
 		std::vector<int> rearrangement_default;
@@ -660,8 +1025,8 @@ namespace tdd {
 						break;
 					}
 				}
-				total_order[i] = a.m_storage_order[i_cur_a];
-				total_inner_shape[i] = a.m_inner_data_shape[i_cur_a];
+				total_order[i] = a.storage_order()[i_cur_a];
+				total_inner_shape[i] = a.inner_data_shape()[i_cur_a];
 				a_inner_order[i_cur_a] = i;
 				i_cur_a++;
 			}
@@ -676,8 +1041,8 @@ namespace tdd {
 						break;
 					}
 				}
-				total_order[i] = b.m_storage_order[i_cur_b] + a.dim_data();
-				total_inner_shape[i] = b.m_inner_data_shape[i_cur_b];
+				total_order[i] = b.storage_order()[i_cur_b] + a.dim_data();
+				total_inner_shape[i] = b.inner_data_shape()[i_cur_b];
 				b_inner_order[i_cur_b] = i;
 				i_cur_b++;
 			}
@@ -707,26 +1072,82 @@ namespace tdd {
 		std::vector<int64_t> para_shape_res;
 		// decide the parallel shape accordingly
 		if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, CUDAcpl::Tensor>) {
-			para_shape_res = std::vector<int64_t>(b.m_para_shape);
+			para_shape_res = std::vector<int64_t>(b.parallel_shape());
 		}
 		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, wcomplex>) {
-			para_shape_res = std::vector<int64_t>(a.m_para_shape);
+			para_shape_res = std::vector<int64_t>(a.parallel_shape());
 		}
 		else {
-			para_shape_res = std::vector<int64_t>(a.m_para_shape);
+			para_shape_res = std::vector<int64_t>(a.parallel_shape());
 			if (parallel_tensor) {
-				para_shape_res.insert(para_shape_res.end(), b.m_para_shape.begin(), b.m_para_shape.end());
+				para_shape_res.insert(para_shape_res.end(), b.parallel_shape().begin(), b.parallel_shape().end());
 			}
 		}
 
+		total_inner_shape[total_inner_shape.size() - 1] = 2;
+
+		cont_plan plan;
+		plan.inner_indices_cmd = std::move(inner_indices_cmd);
+		plan.a_inner_order = std::move(a_inner_order);
+		plan.b_inner_order = std::move(b_inner_order);
+		plan.total_inner_shape = std::move(total_inner_shape);
+		plan.total_order = std::move(total_order);
+		plan.total_shape = std::move(total_shape);
+		plan.para_shape_res = std::move(para_shape_res);
+		return plan;
+	}
+
+	/// <summary>
+	/// The pytorch-like tensordot method. Note that indices should be counted with data indices only.
+	/// Whether to tensor on the parallel indices.
+	/// The operation is supervised by p_ctrl if it is not nullptr, and ctrl::Cancelled is thrown when it is aborted.
+	/// If the controller is approximating, the sub-results are pruned while they are contracted (scalar weights only,
+	/// std::invalid_argument is thrown otherwise), and the estimated loss is recorded in the controller.
+	/// </summary>
+	/// <typeparam name="W"></typeparam>
+	template <typename W1, typename W2>
+	TDD<weight::W_C<W1, W2>>
+		tensordot(const TDD<W1>& a, const TDD<W2>& b,
+		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b,
+		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false, ctrl::Controller* p_ctrl = nullptr) {
+
+		ctrl::Scope scope{ p_ctrl };
+
+		auto&& plan = tensordot_plan(a, b, ils_a, ils_b, rearrangement, parallel_tensor);
+
 		// note that rearrangement does not need be processed.
-		auto&& res_wnode = wnode::contract<W1, W2>(a.m_wnode, a.m_para_shape, b.m_wnode, b.m_para_shape,
-			para_shape_res,	a.m_inner_data_shape, b.m_inner_data_shape,
-			inner_indices_cmd, a_inner_order, b_inner_order, parallel_tensor);
+		node::weightednode<weight::W_C<W1, W2>> res_wnode;
+		auto p_current = ctrl::current();
+		if (p_current && p_current->is_approximating()) {
+			if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+				// prune the sub-results while contracting, and then enforce the budget and the threshold on the whole result
+				auto&& approx = wnode::contract_approx(a.m_wnode, b.m_wnode, a.m_inner_data_shape, b.m_inner_data_shape,
+					plan.inner_indices_cmd, plan.a_inner_order, plan.b_inner_order, plan.total_inner_shape,
+					p_current->approx_threshold(), p_current->level_budget());
+				p_current->record_loss(1. - approx.second);
+				auto&& pruned = wnode::approximate(approx.first, plan.total_inner_shape,
+					p_current->approx_threshold(), p_current->level_budget());
+				res_wnode = std::move(pruned.first);
+				p_current->record_loss(pruned.second);
+			}
+			else {
+				throw std::invalid_argument("approximation is supported for scalar weights only.");
+			}
+		}
+		else {
+			res_wnode = wnode::contract<W1, W2>(a.m_wnode, a.m_para_shape, b.m_wnode, b.m_para_shape,
+				plan.para_shape_res, a.m_inner_data_shape, b.m_inner_data_shape,
+				plan.inner_indices_cmd, plan.a_inner_order, plan.b_inner_order, parallel_tensor);
+		}
 
+		TDD<weight::W_C<W1, W2>> res(std::move(res_wnode), std::move(plan.para_shape_res),
+			std::move(plan.total_shape), std::move(plan.total_order));
 
-		return TDD<weight::W_C<W1, W2>>(std::move(res_wnode), std::move(para_shape_res),
-			std::move(total_shape), std::move(total_order));
+		// reorder the result if the controller asks for it, and the result grows beyond the threshold
+		if (p_current && p_current->sift_threshold() > 0 && res.size() > p_current->sift_threshold()) {
+			res.sift();
+		}
+		return res;
 	}
 
 	/// <summary>
@@ -736,17 +1157,460 @@ namespace tdd {
 	/// <param name="b"></param>
 	/// <param name="num_indices">contract the last num_indices indices of a and first of b</param>
 	/// <param name="parallel_tensor"></param>
+	/// <param name="p_ctrl">The controller of this operation. nullptr for no control.</param>
 	/// <returns></returns>
 	template <typename W1, typename W2>
 	inline TDD<weight::W_C<W1, W2>>
 		tensordot_num(const TDD<W1>& a, const TDD<W2>& b, int num_indices,
-			const std::vector<int>& rearrangement = {}, bool parallel_tensor = false) {
+			const std::vector<int>& rearrangement = {}, bool parallel_tensor = false, ctrl::Controller* p_ctrl = nullptr) {
 		std::vector<int64_t> ia(num_indices);
 		std::vector<int64_t> ib(num_indices);
 		for (int i = 0; i < num_indices; i++) {
 			ia[i] = a.dim_data() - num_indices + i;
 			ib[i] = i;
 		}
-		return tensordot<W1, W2>(a, b, ia, ib, rearrangement, parallel_tensor);
+		return tensordot<W1, W2>(a, b, ia, ib, rearrangement, parallel_tensor, p_ctrl);
+	}
+
+	/// <summary>
+	/// Return the indices (in ascending order) not contracted, which are the indices of the tensordot result.
+	/// </summary>
+	inline std::vector<int64_t> remained_indices(int64_t dim_data, const std::vector<int64_t>& ils) {
+		std::vector<int64_t> res;
+		for (int64_t i = 0; i < dim_data; i++) {
+			if (std::find(ils.begin(), ils.end(), i) == ils.end()) {
+				res.push_back(i);
+			}
+		}
+		return res;
+	}
+
+	/// <summary>
+	/// Return the tensordot result sliced on the given result indices, which are fixed to the given values.
+	/// The operands are sliced before contracting, so that only the sub-tensor required is calculated.
+	/// Note that indices should be counted with data indices only, and fixed_indices are counted in the indices of the
+	/// (unsliced) result, i.e., the remained indices of a followed by those of b.
+	/// </summary>
+	/// <param name="rearrangement">the rearrangement of the unsliced result. The entries of fixed indices are dropped.</param>
+	/// <returns></returns>
+	template <typename W1, typename W2>
+	TDD<weight::W_C<W1, W2>>
+		tensordot_sliced(const TDD<W1>& a, const TDD<W2>& b,
+		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b,
+		const std::vector<int64_t>& fixed_indices, const std::vector<int64_t>& values,
+		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false, ctrl::Controller* p_ctrl = nullptr) {
+
+		ctrl::Scope scope{ p_ctrl };
+
+		// the remained indices of a and b, in the result order
+		auto&& remained_a = remained_indices(a.dim_data(), ils_a);
+		auto&& remained_b = remained_indices(b.dim_data(), ils_b);
+
+		// push the fixed values down to the operands
+		std::vector<int64_t> a_fixed, a_values, b_fixed, b_values;
+		std::vector<bool> is_fixed(remained_a.size() + remained_b.size(), false);
+		for (int i = 0; i < fixed_indices.size(); i++) {
+			is_fixed[fixed_indices[i]] = true;
+			if (fixed_indices[i] < remained_a.size()) {
+				a_fixed.push_back(remained_a[fixed_indices[i]]);
+				a_values.push_back(values[i]);
+			}
+			else {
+				b_fixed.push_back(remained_b[fixed_indices[i] - remained_a.size()]);
+				b_values.push_back(values[i]);
+			}
+		}
+		auto&& a_sliced = a.slice(a_fixed, a_values);
+		auto&& b_sliced = b.slice(b_fixed, b_values);
+
+		// the contracted indices after slicing
+		std::vector<int64_t> ils_a_sliced(ils_a.size()), ils_b_sliced(ils_b.size());
+		for (int i = 0; i < ils_a.size(); i++) {
+			ils_a_sliced[i] = ils_a[i] - std::count_if(a_fixed.begin(), a_fixed.end(),
+				[&](const int64_t& index) { return index < ils_a[i]; });
+			ils_b_sliced[i] = ils_b[i] - std::count_if(b_fixed.begin(), b_fixed.end(),
+				[&](const int64_t& index) { return index < ils_b[i]; });
+		}
+
+		// drop the inner levels of the fixed indices from the rearrangement
+		std::vector<int> rearrangement_sliced;
+		if (!rearrangement.empty()) {
+			auto&& plan = tensordot_plan(a, b, ils_a, ils_b, rearrangement, parallel_tensor);
+			for (int i = 0; i < rearrangement.size(); i++) {
+				if (!is_fixed[plan.total_order[i]]) {
+					rearrangement_sliced.push_back(rearrangement[i]);
+				}
+			}
+		}
+
+		return tensordot<W1, W2>(a_sliced, b_sliced, ils_a_sliced, ils_b_sliced, rearrangement_sliced, parallel_tensor);
+	}
+
+	/// <summary>
+	/// Return the tensordot result traced on the given pairs of result indices, without producing the untraced result.
+	/// The pairs across a and b are contracted together with (ils_a, ils_b), and the pairs inside a or b are traced
+	/// on the operands before contracting.
+	/// Note that indices should be counted with data indices only, and trace_pairs are counted in the indices of the
+	/// (untraced) result, i.e., the remained indices of a followed by those of b.
+	/// </summary>
+	/// <param name="rearrangement">the rearrangement of the untraced result. The entries of traced indices are dropped.</param>
+	/// <returns></returns>
+	template <typename W1, typename W2>
+	TDD<weight::W_C<W1, W2>>
+		tensordot_trace(const TDD<W1>& a, const TDD<W2>& b,
+		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b, const cache::pair_cmd& trace_pairs,
+		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false, ctrl::Controller* p_ctrl = nullptr) {
+
+		ctrl::Scope scope{ p_ctrl };
+
+		// the remained indices of a and b, in the result order
+		auto&& remained_a = remained_indices(a.dim_data(), ils_a);
+		auto&& remained_b = remained_indices(b.dim_data(), ils_b);
+
+		// distribute the trace pairs
+		cache::pair_cmd a_trace, b_trace;
+		std::vector<int64_t> a_traced, b_traced;
+		std::vector<int64_t> ils_a_full(ils_a), ils_b_full(ils_b);
+		std::vector<bool> is_traced(remained_a.size() + remained_b.size(), false);
+		for (const auto& pair : trace_pairs) {
+			is_traced[pair.first] = true;
+			is_traced[pair.second] = true;
+			bool first_in_a = pair.first < remained_a.size();
+			bool second_in_a = pair.second < remained_a.size();
+			auto first = first_in_a ? remained_a[pair.first] : remained_b[pair.first - remained_a.size()];
+			auto second = second_in_a ? remained_a[pair.second] : remained_b[pair.second - remained_a.size()];
+			if (first_in_a && second_in_a) {
+				a_trace.push_back(std::make_pair((int)first, (int)second));
+				a_traced.push_back(first);
+				a_traced.push_back(second);
+			}
+			else if (!first_in_a && !second_in_a) {
+				b_trace.push_back(std::make_pair((int)first, (int)second));
+				b_traced.push_back(first);
+				b_traced.push_back(second);
+			}
+			else {
+				ils_a_full.push_back(first_in_a ? first : second);
+				ils_b_full.push_back(first_in_a ? second : first);
+			}
+		}
+		auto&& a_pd = a.trace(a_trace);
+		auto&& b_pd = b.trace(b_trace);
+
+		// the contracted indices after tracing
+		for (auto&& index : ils_a_full) {
+			index -= std::count_if(a_traced.begin(), a_traced.end(),
+				[&](const int64_t& traced) { return traced < index; });
+		}
+		for (auto&& index : ils_b_full) {
+			index -= std::count_if(b_traced.begin(), b_traced.end(),
+				[&](const int64_t& traced) { return traced < index; });
+		}
+
+		// drop the inner levels of the traced indices from the rearrangement
+		std::vector<int> rearrangement_pd;
+		if (!rearrangement.empty()) {
+			auto&& plan = tensordot_plan(a, b, ils_a, ils_b, rearrangement, parallel_tensor);
+			for (int i = 0; i < rearrangement.size(); i++) {
+				if (!is_traced[plan.total_order[i]]) {
+					rearrangement_pd.push_back(rearrangement[i]);
+				}
+			}
+		}
+
+		return tensordot<W1, W2>(a_pd, b_pd, ils_a_full, ils_b_full, rearrangement_pd, parallel_tensor);
+	}
+
+
+	/// <summary>
+	/// The estimated cost of a contraction.
+	/// </summary>
+	struct cont_estimate {
+		// the predicted node number at each inner level of the result
+		std::vector<double> level_nodes;
+
+		// the predicted node number of the result
+		double nodes;
+
+		// the predicted number of contraction steps
+		double work;
+
+		// the predicted time (in second, single thread)
+		double time;
+	};
+
+	/// <summary>
+	/// Estimate the cost of tensordot without executing it. The prediction follows the iteration strategy of the contraction:
+	/// the levels of a and b are visited in the merged order, and the number of states at each step is bounded by
+	/// (cut width of a) * (cut width of b) * (range of the opened contracted indices), as well as the full tree bound.
+	/// Note that indices should be counted with data indices only.
+	/// </summary>
+	/// <returns></returns>
+	template <typename W1, typename W2>
+	cont_estimate estimate_tensordot(const TDD<W1>& a, const TDD<W2>& b,
+		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b,
+		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false) {
+
+		auto&& plan = tensordot_plan(a, b, ils_a, ils_b, rearrangement, parallel_tensor);
+
+		auto dim_a = a.dim_data();
+		auto dim_b = b.dim_data();
+		auto&& a_widths = wnode::level_statistics(a.w_node(), dim_a).second;
+		auto&& b_widths = wnode::level_statistics(b.w_node(), dim_b).second;
+
+		// the partner level of each contracted level, and -1 for the remained levels
+		std::vector<int64_t> a_partner(dim_a, -1);
+		std::vector<int64_t> b_partner(dim_b, -1);
+		for (const auto& cmd : plan.inner_indices_cmd) {
+			a_partner[cmd.first] = cmd.second;
+			b_partner[cmd.second] = cmd.first;
+		}
+
+		cont_estimate res;
+		res.level_nodes = std::vector<double>(plan.total_order.size(), 0.);
+		res.work = 0.;
+
+		// the number of distinct index values on the result levels processed
+		double prefix = 1.;
+		// the range of contracted indices opened but not closed yet
+		double open_range = 1.;
+
+		int i_a = 0, i_b = 0;
+		while (i_a < dim_a || i_b < dim_b) {
+			// the contracted levels are resolved first, and remained levels follow the new order
+			bool choice_A;
+			if (i_a == dim_a) {
+				choice_A = false;
+			}
+			else if (i_b == dim_b) {
+				choice_A = true;
+			}
+			else if (a_partner[i_a] >= 0) {
+				choice_A = true;
+			}
+			else if (b_partner[i_b] >= 0) {
+				choice_A = false;
+			}
+			else {
+				choice_A = plan.a_inner_order[i_a] < plan.b_inner_order[i_b];
+			}
+
+			double states = (std::min)((double)a_widths[i_a] * b_widths[i_b], prefix) * open_range;
+
+			int64_t partner, range;
+			bool partner_passed;
+			if (choice_A) {
+				partner = a_partner[i_a];
+				range = a.inner_data_shape()[i_a];
+				partner_passed = partner >= 0 && partner < i_b;
+			}
+			else {
+				partner = b_partner[i_b];
+				range = b.inner_data_shape()[i_b];
+				partner_passed = partner >= 0 && partner < i_a;
+			}
+
+			if (partner < 0) {
+				// weave a remained level
+				auto new_order = choice_A ? plan.a_inner_order[i_a] : plan.b_inner_order[i_b];
+				res.level_nodes[new_order] = (std::min)((double)a_widths[i_a] * b_widths[i_b], prefix);
+				res.work += states * range;
+				prefix *= range;
+			}
+			else if (partner_passed) {
+				// close a contracted index opened by the other side
+				res.work += states;
+				open_range /= range;
+			}
+			else {
+				// open a contracted index
+				res.work += states * range;
+				open_range *= range;
+			}
+
+			if (choice_A) {
+				i_a++;
+			}
+			else {
+				i_b++;
+			}
+		}
+
+		res.nodes = 0.;
+		for (const auto& n : res.level_nodes) {
+			res.nodes += n;
+		}
+
+		int64_t para_numel = 1;
+		for (const auto& d : plan.para_shape_res) {
+			para_numel *= d;
+		}
+		res.time = res.work * (DEFAULT_CONT_STEP_TIME + para_numel * DEFAULT_CONT_ELEMENT_TIME);
+		return res;
+	}
+
+
+	/// <summary>
+	/// The pytorch-like tensordot method, conducted in the hybrid Schrodinger-Feynman way: some contracted index pairs
+	/// are sliced, every assignment of their values is contracted independently on the thread pool, and the results are summed up.
+	/// The pairs are chosen greedily until the estimated node number of one slice result fits in slice_budget.
+	/// The slices are contracted one by one on the calling thread instead, if it is a worker of the thread pool already.
+	/// The garbage is not collected until all the slices are finished.
+	/// Note that indices should be counted with data indices only.
+	/// </summary>
+	/// <param name="slice_budget">the maximum estimated node number of one slice</param>
+	/// <returns></returns>
+	template <typename W1, typename W2>
+	TDD<weight::W_C<W1, W2>>
+		tensordot_hsf(const TDD<W1>& a, const TDD<W2>& b,
+		const std::vector<int64_t>& ils_a, const std::vector<int64_t>& ils_b, double slice_budget = DEFAULT_HSF_SLICE_BUDGET,
+		const std::vector<int>& rearrangement = {}, bool parallel_tensor = false, ctrl::Controller* p_ctrl = nullptr) {
+
+		ctrl::Scope scope{ p_ctrl };
+
+		// the contracted indices left after slicing the pairs at the given positions of ils
+		auto rest_indices = [](const std::vector<int64_t>& ils, const std::vector<int64_t>& sliced_indices) {
+			std::vector<int64_t> res;
+			for (const auto& index : ils) {
+				if (std::find(sliced_indices.begin(), sliced_indices.end(), index) == sliced_indices.end()) {
+					res.push_back(index - std::count_if(sliced_indices.begin(), sliced_indices.end(),
+						[&](const int64_t& sliced) { return sliced < index; }));
+				}
+			}
+			return res;
+		};
+
+		// the estimated node number of one slice, if the pairs at the given positions are sliced
+		auto slice_nodes = [&](const std::vector<int64_t>& positions) {
+			std::vector<int64_t> sliced_a, sliced_b;
+			for (const auto& pos : positions) {
+				sliced_a.push_back(ils_a[pos]);
+				sliced_b.push_back(ils_b[pos]);
+			}
+			std::vector<int64_t> zeros(positions.size(), 0);
+			return estimate_tensordot(a.slice(sliced_a, zeros), b.slice(sliced_b, zeros),
+				rest_indices(ils_a, sliced_a), rest_indices(ils_b, sliced_b), rearrangement, parallel_tensor).nodes;
+		};
+
+		// choose the pairs to slice greedily
+		std::vector<int64_t> positions;
+		auto nodes = slice_nodes(positions);
+		while (nodes > slice_budget && positions.size() < ils_a.size()) {
+			int64_t best_pos = -1;
+			double best_nodes = 0.;
+			for (int64_t pos = 0; pos < ils_a.size(); pos++) {
+				if (std::find(positions.begin(), positions.end(), pos) != positions.end()) {
+					continue;
+				}
+				auto candidate = positions;
+				candidate.push_back(pos);
+				auto candidate_nodes = slice_nodes(candidate);
+				if (best_pos < 0 || candidate_nodes < best_nodes) {
+					best_pos = pos;
+					best_nodes = candidate_nodes;
+				}
+			}
+			positions.push_back(best_pos);
+			nodes = best_nodes;
+		}
+
+		if (positions.empty()) {
+			return tensordot<W1, W2>(a, b, ils_a, ils_b, rearrangement, parallel_tensor);
+		}
+
+		std::vector<int64_t> sliced_a, sliced_b, ranges;
+		for (const auto& pos : positions) {
+			sliced_a.push_back(ils_a[pos]);
+			sliced_b.push_back(ils_b[pos]);
+			ranges.push_back(a.data_shape()[ils_a[pos]]);
+		}
+
+		// the slices share the same layout, so the plan is prepared on the first one
+		std::vector<int64_t> zeros(positions.size(), 0);
+		auto&& a_first = a.slice(sliced_a, zeros);
+		auto&& b_first = b.slice(sliced_b, zeros);
+		auto&& plan = tensordot_plan(a_first, b_first, rest_indices(ils_a, sliced_a), rest_indices(ils_b, sliced_b),
+			rearrangement, parallel_tensor);
+		cache::pair_cmd sorted_cmd(plan.inner_indices_cmd);
+		std::sort(sorted_cmd.begin(), sorted_cmd.end(),
+			[](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+				return (a.first < b.first);
+			});
+
+		// the inner indices sliced, sorted in ascending order for wnode::slice
+		std::vector<int64_t> a_inner_reduced, b_inner_reduced;
+		for (int i = 0; i < positions.size(); i++) {
+			a_inner_reduced.push_back(a.inversed_order()[sliced_a[i]]);
+			b_inner_reduced.push_back(b.inversed_order()[sliced_b[i]]);
+		}
+		std::sort(a_inner_reduced.begin(), a_inner_reduced.end());
+		std::sort(b_inner_reduced.begin(), b_inner_reduced.end());
+
+		int64_t slice_num = 1;
+		for (const auto& r : ranges) {
+			slice_num *= r;
+		}
+
+		// contract every slice independently with the explicit frame stack (no coordination among threads is needed).
+		// a worker must not wait for the other tasks of the pool, so the slices are contracted in place on workers.
+		bool on_worker = wnode::iter_para::p_thread_pool->get_thread_num(std::this_thread::get_id()) >= 0;
+		std::vector<std::future<node::weightednode<weight::W_C<W1, W2>>>> results(slice_num);
+		for (int64_t n = 0; n < slice_num; n++) {
+			auto&& slice_task = [&, n] {
+				cache::pair_cmd a_cmd(positions.size()), b_cmd(positions.size());
+				int64_t rest = n;
+				for (int i = 0; i < positions.size(); i++) {
+					int value = rest % ranges[i];
+					rest /= ranges[i];
+					a_cmd[i] = std::make_pair((int)a.inversed_order()[sliced_a[i]], value);
+					b_cmd[i] = std::make_pair((int)b.inversed_order()[sliced_b[i]], value);
+				}
+				auto&& w_a = wnode::slice(a.w_node(), a.parallel_shape(), a.inner_data_shape(), a_cmd, a_inner_reduced);
+				auto&& w_b = wnode::slice(b.w_node(), b.parallel_shape(), b.inner_data_shape(), b_cmd, b_inner_reduced);
+				return wnode::contract_stack<W1, W2>(w_a.get_node(), a.parallel_shape(), w_b.get_node(), b.parallel_shape(),
+					weight::prepare_weight(w_a.weight, w_b.weight, parallel_tensor), plan.para_shape_res,
+					a_first.inner_data_shape(), b_first.inner_data_shape(), sorted_cmd,
+					plan.a_inner_order, plan.b_inner_order, parallel_tensor, nullptr, false);
+			};
+			if (on_worker) {
+				std::packaged_task<node::weightednode<weight::W_C<W1, W2>>()> task(slice_task);
+				results[n] = task.get_future();
+				task();
+			}
+			else {
+				results[n] = wnode::iter_para::p_thread_pool->enqueue(ctrl::bind(slice_task));
+			}
+		}
+
+		for (auto& result : results) {
+			while (result.wait_for(mng::garbage_check_period.load()) != std::future_status::ready) {
+				ctrl::poll();
+			}
+		}
+
+		// all the tasks must finish before leaving, for they refer to the local variables here.
+		node::weightednode<weight::W_C<W1, W2>> res_wnode;
+		std::exception_ptr p_exception = nullptr;
+		for (int64_t n = 0; n < slice_num; n++) {
+			try {
+				auto&& temp = results[n].get();
+				if (!p_exception) {
+					res_wnode = n == 0 ? std::move(temp) : wnode::sum<weight::W_C<W1, W2>>(res_wnode, temp, plan.para_shape_res);
+				}
+			}
+			catch (...) {
+				if (!p_exception) {
+					p_exception = std::current_exception();
+				}
+			}
+		}
+		if (p_exception) {
+			std::rethrow_exception(p_exception);
+		}
+
+		TDD<weight::W_C<W1, W2>> res(std::move(res_wnode), std::move(plan.para_shape_res),
+			std::move(plan.total_shape), std::move(plan.total_order));
+		mng::cache_clear_check();
+		return res;
 	}
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "stdafx.h"
+#include "qomega.hpp"
 
 namespace weight {
 	extern double EPS;
@@ -17,6 +18,8 @@ namespace weight {
 	class W_<CUDAcpl::Tensor, wcomplex> { public: typedef CUDAcpl::Tensor reType; };
 	template <>
 	class W_<CUDAcpl::Tensor, CUDAcpl::Tensor> { public: typedef CUDAcpl::Tensor reType; };
+	template <>
+	class W_<qomega, qomega> { public: typedef qomega reType; };
 
 	template <typename W1, typename W2>
 	using W_C = typename W_<W1, W2>::reType;
@@ -25,12 +28,56 @@ namespace weight {
 		*p_vec = (WCode)round(weight / EPS);
 	}
 
-	inline void get_int_key(WCode* p_vec, CUDAcpl::Tensor weight) {
-		auto&& temp = torch::round(weight / EPS).toType(c10::ScalarType::Long).cpu();
-		auto ptr = (WCode*)temp.data_ptr<WCode>();
+	// the number of codes of one exact weight in the keys
+	constexpr int EXACT_KEY_SIZE = 5;
+
+	/// <summary>
+	/// write the exact code of the weight (EXACT_KEY_SIZE integers)
+	/// </summary>
+	inline void get_int_key(WCode* p_vec, const qomega& weight) noexcept {
+		auto&& c = weight.coefficients();
+		for (int i = 0; i < 4; i++) {
+			p_vec[i] = c[i];
+		}
+		p_vec[4] = weight.denominator();
+	}
+
+	/// <summary>
+	/// Return the adjacent bucket (+1 or -1) if the weight lies within DEFAULT_PROBE_MARGIN (of a bucket) of the
+	/// rounding boundary in get_int_key, and 0 otherwise.
+	/// </summary>
+	inline int boundary_direction(double weight) noexcept {
+		auto x = weight / EPS;
+		auto residual = x - round(x);
+		if (residual > 0.5 - DEFAULT_PROBE_MARGIN) {
+			return 1;
+		}
+		if (residual < DEFAULT_PROBE_MARGIN - 0.5) {
+			return -1;
+		}
+		return 0;
+	}
+
+	/// <summary>
+	/// quantize the data buffer in one pass. The loop is kept simple so that it can be vectorized by the compiler.
+	/// (nearbyint rounds half to even, the same as torch::round)
+	/// </summary>
+	template <typename T>
+	inline void quantize(WCode* p_vec, const T* p_data, int64_t numel) noexcept {
+		const double eps = EPS;
+		for (int64_t i = 0; i < numel; i++) {
+			p_vec[i] = (WCode)std::nearbyint((double)p_data[i] / eps);
+		}
+	}
 
-		for (int i = 0; i < temp.numel(); i++) {
-			p_vec[i] = ptr[i];
+	inline void get_int_key(WCode* p_vec, const CUDAcpl::Tensor& weight) {
+		// read the buffer directly, and copy only if it is not on cpu or not contiguous
+		auto&& temp = (weight.is_cuda() ? weight.cpu() : weight).contiguous();
+		if (temp.scalar_type() == c10::ScalarType::Double) {
+			quantize(p_vec, temp.data_ptr<double>(), temp.numel());
+		}
+		else {
+			quantize(p_vec, temp.data_ptr<float>(), temp.numel());
 		}
 	}
 
@@ -53,16 +100,35 @@ namespace weight {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return CUDAcpl::from_complex(weight);
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return CUDAcpl::from_complex(weight.value());
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return weight;
 		}
 	}
 
+	/// <summary>
+	/// The numerical value of a scalar weight.
+	/// </summary>
+	template <class W>
+	inline wcomplex numerical(const W& weight) noexcept {
+		if constexpr (std::is_same_v<W, qomega>) {
+			return weight.value();
+		}
+		else {
+			return weight;
+		}
+	}
+
 	template <class W>
 	inline CUDAcpl::Tensor res_mul_weight(const CUDAcpl::Tensor& tensor, const W& weight) {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return CUDAcpl::mul_element_wise(tensor, weight);
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return CUDAcpl::mul_element_wise(tensor, weight.value());
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			auto&& sizes = tensor.sizes();
 			std::vector<int64_t> temp_shape(sizes.begin(), sizes.end());
@@ -88,9 +154,12 @@ namespace weight {
 			return abs(a.real() - b.real()) < this_eps &&
 				abs(a.imag() - b.imag()) < this_eps;
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return a == b;
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
-			auto this_eps = CUDAcpl::norm(a) * EPS;
-			this_eps = torch::stack({ this_eps, this_eps }, this_eps.dim());
+			// broadcast the tolerance over the inner dimension instead of stacking a copy
+			auto this_eps = (CUDAcpl::norm(a) * EPS).unsqueeze(a.dim() - 1);
 			return  torch::all(torch::abs(a - b) < this_eps).item().toBool();
 		}
 	}
@@ -106,16 +175,106 @@ namespace weight {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return abs(a.real()) < EPS && abs(a.imag()) < EPS;
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return a.is_zero();
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return torch::all(torch::abs(a) < EPS).item().toBool();
 		}
 	}
 
+	/// <summary>
+	/// (raw buffer version) check whether all the weights are equal to the first one
+	/// </summary>
+	template <typename T>
+	inline bool all_equal_raw(const std::vector<CUDAcpl::Tensor>& weights) {
+		auto p_a = weights[0].data_ptr<T>();
+		auto numel = weights[0].numel();
+		for (int64_t k = 0; k < numel; k += 2) {
+			auto this_eps = (p_a[k] * p_a[k] + p_a[k + 1] * p_a[k + 1]) * EPS;
+			for (int i = 1; i < weights.size(); i++) {
+				auto p_b = weights[i].data_ptr<T>();
+				if (!(std::abs(p_a[k] - p_b[k]) < this_eps && std::abs(p_a[k + 1] - p_b[k + 1]) < this_eps)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// (raw buffer version) check whether each weight is zero
+	/// </summary>
+	template <typename T>
+	inline std::vector<bool> zero_flags_raw(const std::vector<CUDAcpl::Tensor>& weights) {
+		auto numel = weights[0].numel();
+		std::vector<bool> res(weights.size());
+		for (int i = 0; i < weights.size(); i++) {
+			auto p_w = weights[i].data_ptr<T>();
+			bool zero = true;
+			for (int64_t k = 0; k < numel && zero; k++) {
+				zero = std::abs(p_w[k]) < EPS;
+			}
+			res[i] = zero;
+		}
+		return res;
+	}
+
+	/// <summary>
+	/// Check whether all the weights are equal to the first one (in the sense of is_equal), with one synchronization at most.
+	/// The weights should have the same shape.
+	/// </summary>
+	/// <param name="weights"></param>
+	/// <returns></returns>
+	inline bool all_equal(const std::vector<CUDAcpl::Tensor>& weights) {
+		if (weights[0].is_cuda()) {
+			auto&& stacked = torch::stack(weights);
+			auto&& first = stacked.select(0, 0);
+			auto this_eps = (CUDAcpl::norm(first) * EPS).unsqueeze(first.dim() - 1);
+			return torch::all(torch::abs(stacked - first) < this_eps).item().toBool();
+		}
+		// read the buffers directly for cpu tensors
+		std::vector<CUDAcpl::Tensor> contiguous_weights(weights.size());
+		for (int i = 0; i < weights.size(); i++) {
+			contiguous_weights[i] = weights[i].contiguous();
+		}
+		if (weights[0].scalar_type() == c10::ScalarType::Double) {
+			return all_equal_raw<double>(contiguous_weights);
+		}
+		return all_equal_raw<float>(contiguous_weights);
+	}
+
+	/// <summary>
+	/// Check whether each weight is zero (in the sense of is_zero), with one synchronization at most.
+	/// The weights should have the same shape.
+	/// </summary>
+	/// <param name="weights"></param>
+	/// <returns></returns>
+	inline std::vector<bool> zero_flags(const std::vector<CUDAcpl::Tensor>& weights) {
+		if (weights[0].is_cuda()) {
+			auto&& flags = (torch::abs(torch::stack(weights)) < EPS).flatten(1).all(1).cpu();
+			auto p_flags = flags.data_ptr<bool>();
+			return std::vector<bool>(p_flags, p_flags + weights.size());
+		}
+		// read the buffers directly for cpu tensors
+		std::vector<CUDAcpl::Tensor> contiguous_weights(weights.size());
+		for (int i = 0; i < weights.size(); i++) {
+			contiguous_weights[i] = weights[i].contiguous();
+		}
+		if (weights[0].scalar_type() == c10::ScalarType::Double) {
+			return zero_flags_raw<double>(contiguous_weights);
+		}
+		return zero_flags_raw<float>(contiguous_weights);
+	}
+
 	template <class W>
 	inline bool is_exact_zero(const W& a) noexcept {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return a.real() == 0. && a.imag() == 0.;
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return a.is_zero();
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return torch::all(a == 0.).item().toBool();
 		}
@@ -126,6 +285,9 @@ namespace weight {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return wcomplex(1., 0.);
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return qomega(1);
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return CUDAcpl::ones(data_shape);
 		}
@@ -137,6 +299,9 @@ namespace weight {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return wcomplex(1., 0.);
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return qomega(1);
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return CUDAcpl::ones_like(weight);
 		}
@@ -147,6 +312,9 @@ namespace weight {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return wcomplex(0., 0.);
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return qomega(0);
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return CUDAcpl::zeros(data_shape);
 		}
@@ -157,16 +325,36 @@ namespace weight {
 		if constexpr (std::is_same_v<W, wcomplex>) {
 			return wcomplex(0., 0.);
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return qomega(0);
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return CUDAcpl::zeros_like(weight);
 		}
 	}
 
 	template <typename W1, typename W2>
-	inline W_C<W1, W2> mul(const W1& a, const W2& b) noexcept {
+	inline W_C<W1, W2> mul(const W1& a, const W2& b) {
 		return CUDAcpl::mul_element_wise(a, b);
 	}
 
+	/// <summary>
+	/// multiply the weight by a real factor (in the precision of the weight)
+	/// </summary>
+	template <class W>
+	inline W scale(const W& a, double s) {
+		if constexpr (std::is_same_v<W, wcomplex>) {
+			return a * (typename wcomplex::value_type)s;
+		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			// the factors are products of index ranges
+			return a * qomega((int64_t)std::llround(s));
+		}
+		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
+			return a * s;
+		}
+	}
+
 	/// <summary>
 	/// get the reciprocal, and if the element in a is zero, the corresponding reciprocal element is zero.
 	/// </summary>
@@ -183,6 +371,9 @@ namespace weight {
 				return wcomplex(1., 0.) / a;
 			}
 		}
+		else if constexpr (std::is_same_v<W, qomega>) {
+			return a.is_zero() ? qomega(0) : a.inverse();
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			return CUDAcpl::reciprocal_without_zero(a);
 		}
@@ -190,10 +381,13 @@ namespace weight {
 
 
 	template <typename W1, typename W2>
-	inline W_C<W1, W2> prepare_weight(const W1& a, const W2& b, bool parallel_tensor) noexcept {
+	inline W_C<W1, W2> prepare_weight(const W1& a, const W2& b, bool parallel_tensor) {
 		if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
 			return a * b;
 		}
+		else if constexpr (std::is_same_v<W1, qomega> && std::is_same_v<W2, qomega>) {
+			return a * b;
+		}
 		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, CUDAcpl::Tensor>) {
 			if (parallel_tensor) {
 				return CUDAcpl::tensordot(a, b, {}, {});
@@ -210,7 +404,8 @@ namespace weight {
 	// expand the dimensions at the back of the tensor weight
 	template <typename W1, typename W2>
 	inline W_C<W1, W2> weight_expanded_back(const W1& weight, const std::vector<int64_t>& para_shape_res, bool parallel_tensor) {
-		if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+		if constexpr ((std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) ||
+			(std::is_same_v<W1, qomega> && std::is_same_v<W2, qomega>)) {
 			return weight;
 		}
 		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, CUDAcpl::Tensor>) {
@@ -248,7 +443,8 @@ namespace weight {
 	// expand the dimensions at the front of the tensor weight
 	template <typename W1, typename W2>
 	inline W_C<W1, W2> weight_expanded_front(const W2& weight, const std::vector<int64_t>& para_shape_res, bool parallel_tensor) {
-		if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+		if constexpr ((std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) ||
+			(std::is_same_v<W1, qomega> && std::is_same_v<W2, qomega>)) {
 			return weight;
 		}
 		else if constexpr (std::is_same_v<W1, CUDAcpl::Tensor> && std::is_same_v<W2, CUDAcpl::Tensor>) {
@@ -293,7 +489,7 @@ namespace weight {
 		W nweight2;
 		W renorm_coef;
 
-		sum_nweights(W&& _nweight1, W&& _nweight2, W&& _renorm_coef) noexcept {
+		sum_nweights(W&& _nweight1, W&& _nweight2, W&& _renorm_coef) {
 			nweight1 = std::move(_nweight1);
 			nweight2 = std::move(_nweight2);
 			renorm_coef = std::move(_renorm_coef);
@@ -4,6 +4,7 @@
 namespace mng {
 	inline void cache_clear_check();
 	extern std::atomic<std::chrono::duration<double>> garbage_check_period;
+	extern std::atomic<int> stack_cont_depth;
 }
 
 namespace wnode {
@@ -24,6 +25,11 @@ namespace wnode {
 	template <class W>
 	W get_normalizer(const node::succ_ls<W>& successors) {
 		if constexpr (std::is_same_v<W, wcomplex>) {
+			if (successors.size() == 2) {
+				// the qubit case, unrolled
+				double norm_0 = norm(successors[0].weight);
+				return norm(successors[1].weight) - norm_0 > weight::EPS * norm_0 ? successors[1].weight : successors[0].weight;
+			}
 			int i_max = 0;
 			double norm_max = norm(successors[0].weight);
 			for (int i = 1; i < successors.size(); i++) {
@@ -36,6 +42,16 @@ namespace wnode {
 			}
 			return successors[i_max].weight;
 		}
+		else if constexpr (std::is_same_v<W, weight::qomega>) {
+			// the magnitudes are compared exactly, so the choice is invariant under scaling
+			int i_max = 0;
+			for (int i = 1; i < successors.size(); i++) {
+				if (weight::qomega::compare_magnitude(successors[i].weight, successors[i_max].weight) > 0) {
+					i_max = i;
+				}
+			}
+			return successors[i_max].weight;
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			auto&& sizes = successors[0].weight.sizes();
 			auto norm_max = CUDAcpl::norm(successors[0].weight);
@@ -96,6 +112,37 @@ namespace wnode {
 		return (a.get_node() == b.get_node() && weight::is_equal(a.weight, b.weight));
 	}
 
+	/// <summary>
+	/// The normalization of a range-2 (qubit) node of scalar weights, unrolled from normalize.
+	/// </summary>
+	template <class W>
+	node::weightednode<W> normalize_2(const W& wei, int order, node::succ_ls<W>&& successors) {
+		auto&& succ_0 = successors[0];
+		auto&& succ_1 = successors[1];
+		if (is_equal(succ_0, succ_1)) {
+			return node::weightednode<W>(weight::mul(wei, succ_0.weight), succ_0.get_node());
+		}
+
+		W weig_max{ get_normalizer(successors) };
+		if (weight::is_exact_zero(weig_max)) {
+			return node::weightednode<W>{ std::move(weig_max), nullptr };
+		}
+
+		W reciprocal{ weight::reciprocal_without_zero(weig_max) };
+		succ_0.weight = weight::mul(succ_0.weight, reciprocal);
+		if (weight::is_zero(succ_0.weight)) {
+			succ_0.weight = weight::zeros_like(wei);
+			succ_0.set_node(nullptr);
+		}
+		succ_1.weight = weight::mul(succ_1.weight, reciprocal);
+		if (weight::is_zero(succ_1.weight)) {
+			succ_1.weight = weight::zeros_like(wei);
+			succ_1.set_node(nullptr);
+		}
+
+		return node::weightednode<W>::get_wnode(weight::mul(weig_max, wei), order, std::move(successors));
+	}
+
 	/// <summary>
 /// Conduct the normalization of this wnode.
 /// This method only normalize the given wnode, and assumes the wnodes under it are already normalized.
@@ -103,14 +150,49 @@ namespace wnode {
 /// </summary>
 /// <returns>Return the normalized node and normalization coefficients as a wnode.</returns>
 	template <class W>
-	node::weightednode<W> normalize(const W& wei, int order, std::vector<node::weightednode<W>>&& successors) {
+	node::weightednode<W> normalize(const W& wei, int order, node::succ_ls<W>&& successors) {
+		if constexpr (!std::is_same_v<W, CUDAcpl::Tensor>) {
+			if (successors.size() == 2) {
+				return normalize_2(wei, order, std::move(successors));
+			}
+		}
 
 		// subnode equality check
 		bool all_equal = true;
-		for (auto p_succ = successors.begin() + 1; p_succ != successors.end(); p_succ++) {
-			if (!is_equal(successors[0], *p_succ)) {
-				all_equal = false;
-				break;
+		if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
+			// compare the nodes first, and then all the weights at once
+			bool same_shape = true;
+			for (auto p_succ = successors.begin() + 1; p_succ != successors.end(); p_succ++) {
+				if (successors[0].get_node() != p_succ->get_node()) {
+					all_equal = false;
+					break;
+				}
+				same_shape = same_shape && successors[0].weight.sizes() == p_succ->weight.sizes();
+			}
+			if (all_equal) {
+				if (same_shape) {
+					std::vector<CUDAcpl::Tensor> weights(successors.size());
+					for (int i = 0; i < successors.size(); i++) {
+						weights[i] = successors[i].weight;
+					}
+					all_equal = weight::all_equal(weights);
+				}
+				else {
+					for (auto p_succ = successors.begin() + 1; p_succ != successors.end(); p_succ++) {
+						if (!weight::is_equal(successors[0].weight, p_succ->weight)) {
+							all_equal = false;
+							break;
+						}
+					}
+				}
+			}
+		}
+		else {
+			for (auto p_succ = successors.begin() + 1; p_succ != successors.end(); p_succ++) {
+				if (!is_equal(successors[0], *p_succ)) {
+					all_equal = false;
+					break;
+				}
 			}
 		}
 		if (all_equal) {
@@ -128,12 +210,40 @@ namespace wnode {
 		}
 
 		W reciprocal{ weight::reciprocal_without_zero(weig_max) };
-		for (auto&& succ : successors) {
-			succ.weight = weight::mul(succ.weight, reciprocal);
-			// check whether the successor weight is zero, and redirect to terminal node if so
-			if (weight::is_zero(succ.weight)) {
-				succ.weight = weight::zeros_like(wei);
-				succ.set_node(nullptr);
+		if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
+			bool same_shape = true;
+			std::vector<CUDAcpl::Tensor> weights(successors.size());
+			for (int i = 0; i < successors.size(); i++) {
+				successors[i].weight = weight::mul(successors[i].weight, reciprocal);
+				weights[i] = successors[i].weight;
+				same_shape = same_shape && weights[0].sizes() == weights[i].sizes();
+			}
+			// check whether the successor weights are zero all at once, and redirect to terminal node if so
+			std::vector<bool> zero_flags;
+			if (same_shape) {
+				zero_flags = weight::zero_flags(weights);
+			}
+			else {
+				zero_flags = std::vector<bool>(successors.size());
+				for (int i = 0; i < successors.size(); i++) {
+					zero_flags[i] = weight::is_zero(weights[i]);
+				}
+			}
+			for (int i = 0; i < successors.size(); i++) {
+				if (zero_flags[i]) {
+					successors[i].weight = weight::zeros_like(wei);
+					successors[i].set_node(nullptr);
+				}
+			}
+		}
+		else {
+			for (auto&& succ : successors) {
+				succ.weight = weight::mul(succ.weight, reciprocal);
+				// check whether the successor weight is zero, and redirect to terminal node if so
+				if (weight::is_zero(succ.weight)) {
+					succ.weight = weight::zeros_like(wei);
+					succ.set_node(nullptr);
+				}
 			}
 		}
 
@@ -151,6 +261,8 @@ namespace wnode {
 		const std::vector<int64_t>& data_shape,
 		const std::vector<int64_t>& storage_order, int depth) {
 
+		ctrl::check();
+
 		node::weightednode<W> res;
 		// checks whether the tensor is reduced to the [[...[val]...]] form
 		auto&& dim_data = data_shape.size() - 1;
@@ -166,7 +278,7 @@ namespace wnode {
 
 		//note: torch::chunk does not work here
 
-		auto new_successors = std::vector<node::weightednode<W>>(data_shape[split_pos]);
+		auto new_successors = node::succ_ls<W>(data_shape[split_pos]);
 		for (int i = 0; i < data_shape[split_pos]; i++) {
 			new_successors[i] = as_tensor_iterate<W>(
 				// -1 is because the extra inner dim for real and imag
@@ -179,6 +291,143 @@ namespace wnode {
 	}
 
 
+	/// <summary>
+	/// Read the terminal weighted nodes from the contiguous buffer of a CUDAcpl tensor.
+	/// </summary>
+	template <class W, typename T>
+	inline void read_terminals(std::vector<node::weightednode<W>>& terminals, const T* p_data) noexcept {
+		for (int64_t i = 0; i < terminals.size(); i++) {
+			terminals[i] = node::weightednode<W>(W(p_data[2 * i], p_data[2 * i + 1]), nullptr);
+		}
+	}
+
+	/// <summary>
+	/// To create the weighted node bottom-up, level by level (scalar weight, without parallel indices).
+	/// The tensor is first permuted into the storage order, so that the successors of every node at a level are
+	/// a contiguous block of the level below. The identical blocks are deduplicated before normalization, so each
+	/// distinct sub-tensor touches the unique table only once, and no torch operation is issued per element.
+	/// </summary>
+	/// <param name="t">the CUDAcpl tensor without parallel indices</param>
+	/// <param name="data_shape">Note that an *extra dimension* of 2 is needed at the end.</param>
+	/// <returns></returns>
+	template <class W>
+	node::weightednode<W> as_tensor_bottom_up(const CUDAcpl::Tensor& t,
+		const std::vector<int64_t>& data_shape,
+		const std::vector<int64_t>& storage_order) {
+
+		auto&& dim_data = data_shape.size() - 1;
+		std::vector<int64_t> permutation(storage_order.begin(), storage_order.end());
+		permutation.push_back(dim_data);
+		auto&& temp = (t.is_cuda() ? t.cpu() : t).permute(permutation).contiguous();
+
+		// the weighted nodes of all the sub-tensors at the current level, in the storage order
+		std::vector<node::weightednode<W>> level(temp.numel() / 2);
+		if (temp.scalar_type() == c10::ScalarType::Double) {
+			read_terminals<W>(level, temp.data_ptr<double>());
+		}
+		else {
+			read_terminals<W>(level, temp.data_ptr<float>());
+		}
+
+		for (int depth = (int)dim_data - 1; depth >= 0; depth--) {
+			ctrl::check();
+
+			auto range = data_shape[storage_order[depth]];
+			auto num_blocks = (int64_t)level.size() / range;
+			std::vector<node::weightednode<W>> upper_level(num_blocks);
+			boost::unordered_map<cache::block_key<W>, int64_t> block_table;
+			for (int64_t i = 0; i < num_blocks; i++) {
+				auto&& key = cache::block_key<W>(level.data() + i * range, range);
+				auto&& p_find_res = block_table.find(key);
+				if (p_find_res != block_table.end()) {
+					upper_level[i] = upper_level[p_find_res->second];
+					continue;
+				}
+				auto&& new_successors = node::succ_ls<W>(level.begin() + i * range, level.begin() + (i + 1) * range);
+				upper_level[i] = normalize<W>(weight::ones<W>({}), depth, std::move(new_successors));
+				block_table.emplace(key, i);
+			}
+			// the keys borrow the blocks of this level, so they are released first
+			block_table.clear();
+			level = std::move(upper_level);
+		}
+		return std::move(level[0]);
+	}
+
+	/// <summary>
+	/// To create the weighted node from the sorted sparse entries, path by path.
+	/// The entries in [begin, end) share the coordinates of the depths above, and are split into contiguous runs
+	/// by the coordinate at this depth. The successors without any entry are zero.
+	/// </summary>
+	/// <param name="indices">the coordinates of the entries, of shape (nnz, dim_data) in row-major order</param>
+	/// <param name="entries">the entry positions sorted along the storage order</param>
+	/// <returns></returns>
+	template <class W>
+	node::weightednode<W> as_sparse_iterate(const std::vector<int64_t>& indices, const std::vector<W>& values,
+		const std::vector<int64_t>& entries, int64_t begin, int64_t end,
+		const std::vector<int64_t>& data_shape,
+		const std::vector<int64_t>& storage_order, int depth) {
+
+		ctrl::check();
+
+		if (begin == end) {
+			return node::weightednode<W>(weight::zeros<W>({}), nullptr);
+		}
+		int dim_data = storage_order.size();
+		if (depth == dim_data) {
+			// the values of duplicated coordinates are summed up
+			auto&& value = weight::zeros<W>({});
+			for (int64_t i = begin; i < end; i++) {
+				value = value + values[entries[i]];
+			}
+			return node::weightednode<W>(std::move(value), nullptr);
+		}
+
+		int split_pos = storage_order[depth];
+		auto new_successors = node::succ_ls<W>(data_shape[split_pos], node::weightednode<W>(weight::zeros<W>({}), nullptr));
+		int64_t run_begin = begin;
+		while (run_begin < end) {
+			auto coordinate = indices[entries[run_begin] * dim_data + split_pos];
+			int64_t run_end = run_begin + 1;
+			while (run_end < end && indices[entries[run_end] * dim_data + split_pos] == coordinate) {
+				run_end++;
+			}
+			new_successors[coordinate] = as_sparse_iterate<W>(indices, values, entries, run_begin, run_end,
+				data_shape, storage_order, depth + 1);
+			run_begin = run_end;
+		}
+		// normalize this depth
+		return normalize<W>(weight::ones<W>({}), depth, std::move(new_successors));
+	}
+
+	/// <summary>
+	/// To create the weighted node iteratively from the scalar values (in row-major order), according to the instructions.
+	/// </summary>
+	/// <param name="strides">the row-major strides of data indices</param>
+	/// <param name="offset">the position of the current sub-tensor in values</param>
+	/// <returns></returns>
+	template <class W>
+	node::weightednode<W> as_values_iterate(const std::vector<W>& values,
+		const std::vector<int64_t>& strides,
+		const std::vector<int64_t>& data_shape,
+		const std::vector<int64_t>& storage_order, int64_t offset, int depth) {
+
+		ctrl::check();
+
+		if (depth == data_shape.size()) {
+			return node::weightednode<W>(W{ values[offset] }, nullptr);
+		}
+
+		int split_pos = storage_order[depth];
+		auto new_successors = node::succ_ls<W>(data_shape[split_pos]);
+		for (int i = 0; i < data_shape[split_pos]; i++) {
+			new_successors[i] = as_values_iterate<W>(values, strides, data_shape, storage_order,
+				offset + i * strides[split_pos], depth + 1);
+		}
+		// normalize this depth
+		return normalize<W>(weight::ones<W>({}), depth, std::move(new_successors));
+	}
+
 	/// <summary>
 	/// 
 	/// </summary>
@@ -222,6 +471,7 @@ namespace wnode {
 						uniform_tensor = p_find_res->second;
 						cache::Global_Cache<W>::CUDAcpl_cache.first.unlock_shared();
 						//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+						ctrl::count_hit();
 					}
 					else {
 						cache::Global_Cache<W>::CUDAcpl_cache.first.unlock_shared();
@@ -291,7 +541,12 @@ namespace wnode {
 		auto&& dim_data = inner_data_shape.size() - 1;
 		CUDAcpl::Tensor res;
 		if (w_node.get_node() == nullptr) {
-			res = CUDAcpl::mul_element_wise(CUDAcpl::ones(para_shape), w_node.weight);
+			if constexpr (std::is_same_v<W, weight::qomega>) {
+				res = CUDAcpl::mul_element_wise(CUDAcpl::ones(para_shape), w_node.weight.value());
+			}
+			else {
+				res = CUDAcpl::mul_element_wise(CUDAcpl::ones(para_shape), w_node.weight);
+			}
 			n_extra_one = dim_data;
 		}
 		else {
@@ -313,6 +568,45 @@ namespace wnode {
 		return res;
 	}
 
+	/// <summary>
+	/// Write the amplitudes under the node into the strided buffer by depth-first search, without intermediate tensors.
+	/// The indices skipped by the successors are broadcast, and the zero sub-tensors are not visited,
+	/// so the buffer should be zero-filled in advance. (scalar weight only)
+	/// </summary>
+	/// <param name="p_node">the node at or below this depth (nullptr for the terminal)</param>
+	/// <param name="value">the product of the weights along the path</param>
+	/// <param name="p_out">the position of the current sub-tensor in the buffer</param>
+	/// <param name="inner_data_shape">Note that an *extra dimension* of 2 is needed at the end.</param>
+	/// <param name="strides">the buffer strides of the inner data indices, and of the real/imag dimension at last</param>
+	template <class W, typename T>
+	void to_buffer_iterate(const node::Node<W>* p_node, const wcomplex& value, int depth, T* p_out,
+		const std::vector<int64_t>& inner_data_shape, const std::vector<int64_t>& strides) noexcept {
+
+		if (value == wcomplex(0., 0.)) {
+			return;
+		}
+		int dim_data = inner_data_shape.size() - 1;
+		if (depth == dim_data) {
+			p_out[0] = (T)value.real();
+			p_out[strides[dim_data]] = (T)value.imag();
+			return;
+		}
+
+		if (p_node != nullptr && p_node->get_order() == depth) {
+			auto&& successors = p_node->get_successors();
+			for (int i = 0; i < successors.size(); i++) {
+				to_buffer_iterate<W, T>(successors[i].get_node(), value * weight::numerical(successors[i].weight),
+					depth + 1, p_out + i * strides[depth], inner_data_shape, strides);
+			}
+		}
+		else {
+			// the index is reduced at this depth
+			for (int64_t i = 0; i < inner_data_shape[depth]; i++) {
+				to_buffer_iterate<W, T>(p_node, value, depth + 1, p_out + i * strides[depth], inner_data_shape, strides);
+			}
+		}
+	}
+
 	/// <summary>
 	/// return the result of weightednode multiplied by the scalar (or tensor)
 	/// </summary>
@@ -348,13 +642,16 @@ namespace wnode {
 			if constexpr (std::is_same_v<W, wcomplex>) {
 				return node::weightednode<W>(std::conj(w_node.weight), nullptr);
 			}
+			else if constexpr (std::is_same_v<W, weight::qomega>) {
+				return node::weightednode<W>(w_node.weight.conj(), nullptr);
+			}
 			else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 				return node::weightednode<W>(CUDAcpl::conj(w_node.weight), nullptr);
 			}
 		}
 		else {
 			auto&& successors = w_node.get_node()->get_successors();
-			std::vector<node::weightednode<W>> new_successors(successors.size());
+			node::succ_ls<W> new_successors(successors.size());
 			for (int i = 0; i < successors.size(); i++) {
 				new_successors[i] = wnode::conj(successors[i]);
 			}
@@ -363,6 +660,10 @@ namespace wnode {
 				return node::weightednode<W>::get_wnode(std::conj(w_node.weight), 
 					w_node.get_node()->get_order(), std::move(new_successors));
 			}
+			else if constexpr (std::is_same_v<W, weight::qomega>) {
+				return node::weightednode<W>::get_wnode(w_node.weight.conj(),
+					w_node.get_node()->get_order(), std::move(new_successors));
+			}
 			else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 				return node::weightednode<W>::get_wnode(CUDAcpl::conj(w_node.weight),
 					w_node.get_node()->get_order(), std::move(new_successors));
@@ -381,13 +682,16 @@ namespace wnode {
 			if constexpr (std::is_same_v<W, wcomplex>) {
 				return node::weightednode<W>(std::norm(w_node.weight), nullptr);
 			}
+			else if constexpr (std::is_same_v<W, weight::qomega>) {
+				return node::weightednode<W>(w_node.weight.norm(), nullptr);
+			}
 			else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 				return node::weightednode<W>(CUDAcpl::norm(w_node.weight), nullptr);
 			}
 		}
 		else {
 			auto&& successors = w_node.get_node()->get_successors();
-			std::vector<node::weightednode<W>> new_successors(successors.size());
+			node::succ_ls<W> new_successors(successors.size());
 			for (int i = 0; i < successors.size(); i++) {
 				new_successors[i] = wnode::norm(successors[i]);
 			}
@@ -396,6 +700,10 @@ namespace wnode {
 				return node::weightednode<W>::get_wnode(std::norm(w_node.weight),
 					w_node.get_node()->get_order(), std::move(new_successors));
 			}
+			else if constexpr (std::is_same_v<W, weight::qomega>) {
+				return node::weightednode<W>::get_wnode(w_node.weight.norm(),
+					w_node.get_node()->get_order(), std::move(new_successors));
+			}
 			else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 				return node::weightednode<W>::get_wnode(CUDAcpl::norm(w_node.weight),
 					w_node.get_node()->get_order(), std::move(new_successors));
@@ -425,6 +733,9 @@ namespace wnode {
 			auto norm2 = norm(weight2);
 			renorm_coef = (norm2 - norm1 > weight::EPS * norm1) ? weight2 : weight1;
 		}
+		else if constexpr (std::is_same_v<W, weight::qomega>) {
+			renorm_coef = weight::qomega::compare_magnitude(weight2, weight1) > 0 ? weight2 : weight1;
+		}
 		else if constexpr (std::is_same_v<W, CUDAcpl::Tensor>) {
 			auto norm2 = CUDAcpl::norm(weight2);
 			auto norm1 = CUDAcpl::norm(weight1);
@@ -466,6 +777,8 @@ namespace wnode {
 		const node::weightednode<W>& w_node1,
 		const node::weightednode<W>& w_node2, const W& renorm_coef, const std::vector<int64_t>& para_shape) {
 
+		ctrl::check();
+
 		node::weightednode<W> res;
 		if (w_node1.get_node() == nullptr && w_node2.get_node() == nullptr) {
 			return node::weightednode<W>(weight::mul((w_node1.weight + w_node2.weight), renorm_coef), nullptr);
@@ -484,6 +797,7 @@ namespace wnode {
 			res = p_find_res->second.get_weightednode();
 			cache::Global_Cache<W>::sum_cache.first.unlock_shared();
 			//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+			ctrl::count_hit();
 			res.weight = weight::mul(res.weight, renorm_coef);
 			return res;
 		}
@@ -511,7 +825,7 @@ namespace wnode {
 				p_wnode_2 = &w_node2;
 			}
 
-			auto&& new_successors = std::vector<node::weightednode<W>>(p_wnode_1->get_node()->get_range());
+			auto&& new_successors = node::succ_ls<W>(p_wnode_1->get_node()->get_range());
 
 			bool not_operated = true;
 			if (p_wnode_2->get_node() != nullptr) {
@@ -609,13 +923,15 @@ namespace wnode {
 		const std::vector<int64_t>& data_shape,
 		const cache::pair_cmd& remained_ls, const cache::pair_cmd& waiting_ls, const std::vector<int64_t>& new_order) {
 
+		ctrl::check();
+
 		if (w_node.get_node() == nullptr) {
 			// close all the unprocessed indices
 			double scale = 1.;
 			for (const auto& cmd : remained_ls) {
 				scale *= data_shape[cmd.first];
 			}
-			return node::weightednode<W>(w_node.weight * scale, nullptr);
+			return node::weightednode<W>(weight::scale(w_node.weight, scale), nullptr);
 		}
 
 		node::weightednode<W> res;
@@ -630,6 +946,7 @@ namespace wnode {
 			res = p_find_res->second.get_weightednode();
 			cache::Global_Cache<W>::trace_cache.first.unlock_shared();
 			//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+			ctrl::count_hit();
 			res.weight = weight::mul(res.weight, w_node.weight);
 			return res;
 		}
@@ -701,7 +1018,7 @@ namespace wnode {
 						remained_ls_pd[0].second, 0)
 					);
 
-					auto&& new_successors = std::vector<node::weightednode<W>>(range);
+					auto&& new_successors = node::succ_ls<W>(range);
 					if (order == remained_ls_pd[0].first) {
 						int index_val = 0;
 						auto&& i_new = new_successors.begin();
@@ -739,7 +1056,7 @@ namespace wnode {
 
 			if (not_operated) {
 				// in this case, no operation can be performed on this node, so we move on the the following nodes.
-				auto&& new_successors = std::vector<node::weightednode<W>>(w_node.get_node()->get_range());
+				auto&& new_successors = node::succ_ls<W>(w_node.get_node()->get_range());
 				auto&& i_new = new_successors.begin();
 				for (auto&& i = successors.begin(); i != successors.end(); i++, i_new++) {
 					if (i->get_node() == nullptr) {
@@ -753,7 +1070,7 @@ namespace wnode {
 				res = normalize<W>(weight::ones<W>(para_shape), new_order[order], std::move(new_successors));
 			}
 
-			res.weight = res.weight * scale;
+			res.weight = weight::scale(res.weight, scale);
 
 			// add to the cache
 			//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
@@ -858,14 +1175,14 @@ namespace wnode {
 		auto&& successors = w_node.get_node()->get_successors();
 
 		if (remained_ls_pd.empty()) {
-			std::vector<node::weightednode<W>> new_successors(successors.size());
+			node::succ_ls<W> new_successors(successors.size());
 			for (int i = 0; i < successors.size(); i++) {
 				new_successors[i] = wnode::slice_iterate(successors[i], para_shape, data_shape, remained_ls_pd, slice_cache, new_order);
 			}
 			res = normalize<W>(weight::ones<W>(para_shape), new_order[order], std::move(new_successors));
 		}
 		else{
-			std::vector<node::weightednode<W>> new_successors(successors.size());
+			node::succ_ls<W> new_successors(successors.size());
 			if (order < remained_ls_pd[0].first) {
 				for (int i = 0; i < successors.size(); i++) {
 					new_successors[i] = wnode::slice_iterate(successors[i], para_shape, data_shape, remained_ls_pd, slice_cache, new_order);
@@ -952,7 +1269,7 @@ namespace wnode {
 		}
 
 		auto successors = w_node.get_node()->get_successors();
-		std::vector<node::weightednode<W>> new_successors{ successors.size() };
+		node::succ_ls<W> new_successors{ successors.size() };
 
 		for (int i = 0; i < successors.size(); i++) {
 			new_successors[i] = shift(successors[i], order_benchmark, shift_cache);
@@ -968,7 +1285,7 @@ namespace wnode {
 	node::weightednode<W> stack(const std::vector<node::weightednode<W>>& nodes_ls, 
 		const std::vector<int64_t>& parallel_shape) {
 
-		std::vector<node::weightednode<W>> new_successors{ nodes_ls };
+		node::succ_ls<W> new_successors(nodes_ls.begin(), nodes_ls.end());
 
 		for (int i = 0; i < nodes_ls.size(); i++) {
 			boost::unordered_map<node::Node<W>*, node::Node<W>*> shift_cache{};
@@ -980,75 +1297,511 @@ namespace wnode {
 
 
 
-	///////////////////////////////////////////////////////////////////////////////
-	// Iteration Parallelism for cont
-	namespace iter_para {
-		extern ThreadPool* p_thread_pool;
+	/// <summary>
+	/// Return the sub weighted node when the index of the given level is fixed to value.
+	/// Note that w_node should not be of order smaller than level.
+	/// </summary>
+	template <class W>
+	inline node::weightednode<W> cofactor(const node::weightednode<W>& w_node, int level, int value) {
+		if (w_node.get_node() == nullptr || w_node.get_node()->get_order() != level) {
+			return w_node;
+		}
+		auto&& succ = w_node.get_node()->get_successors()[value];
+		return node::weightednode<W>(weight::mul(w_node.weight, succ.weight), succ.get_node());
+	}
 
-		template <typename W1, typename W2>
-		struct branch_state {
-			int thread_count;
-			node::weightednode<weight::W_C<W1, W2>> w_node;
+	/// <summary>
+	/// Note: here we adopt a local cache, because the same node will be operated in the same way during one swapping.
+	/// </summary>
+	/// <param name="level">the upper one of the two levels swapped</param>
+	template <class W>
+	node::weightednode<W> swap_levels_iterate(const node::weightednode<W>& w_node,
+		const std::vector<int64_t>& para_shape,
+		const std::vector<int64_t>& inner_data_shape,
+		int level, boost::unordered_map<node::Node<W>*, node::weightednode<W>>& swap_cache) {
 
-			branch_state() noexcept {
-				thread_count = 0;
+		if (w_node.get_node() == nullptr) {
+			return w_node;
+		}
+
+		// w_node.get_node() is not nullptr
+		auto order = w_node.get_node()->get_order();
+
+		// the nodes below the swapped levels are not affected
+		if (order > level + 1) {
+			return w_node;
+		}
+
+		node::weightednode<W> res;
+
+		// look up in the cache
+		auto&& p_find_res = swap_cache.find(w_node.get_node());
+		if (p_find_res != swap_cache.end()) {
+			res = p_find_res->second;
+			res.weight = weight::mul(res.weight, w_node.weight);
+			return res;
+		}
+
+		if (order < level) {
+			auto&& successors = w_node.get_node()->get_successors();
+			node::succ_ls<W> new_successors(successors.size());
+			for (int i = 0; i < successors.size(); i++) {
+				new_successors[i] = wnode::swap_levels_iterate(successors[i], para_shape, inner_data_shape, level, swap_cache);
 			}
-		};
+			res = normalize<W>(weight::ones<W>(para_shape), order, std::move(new_successors));
+		}
+		else {
+			// rebuild the two levels from the cofactors, with the ranges exchanged
+			node::weightednode<W> unit{ weight::ones<W>(para_shape), w_node.get_node() };
+			auto range_upper = inner_data_shape[level];
+			auto range_lower = inner_data_shape[level + 1];
+
+			node::succ_ls<W> new_successors(range_lower);
+			for (int j = 0; j < range_lower; j++) {
+				node::succ_ls<W> lower_successors(range_upper);
+				for (int i = 0; i < range_upper; i++) {
+					lower_successors[i] = cofactor(cofactor(unit, level, i), level + 1, j);
+				}
+				new_successors[j] = normalize<W>(weight::ones<W>(para_shape), level + 1, std::move(lower_successors));
+			}
+			res = normalize<W>(weight::ones<W>(para_shape), level, std::move(new_successors));
+		}
 
-		template <typename W1, typename W2>
-		struct iter_state {
-			std::vector<branch_state<W1, W2>> state;
-			std::shared_mutex m;
+		swap_cache[w_node.get_node()] = res;
 
-			void init(int n) noexcept {
-				state.resize(n);
+		res.weight = weight::mul(res.weight, w_node.weight);
+		return res;
+	}
+
+	/// <summary>
+	/// Collect the node (and its successors) on the two swapped levels.
+	/// </summary>
+	template <class W>
+	void swapped_nodes_collect(const node::Node<W>* p_node, int level, boost::unordered_set<const node::Node<W>*>& node_set) {
+		if (p_node == nullptr || p_node->get_order() < level || p_node->get_order() > level + 1) {
+			return;
+		}
+		node_set.insert(p_node);
+		if (p_node->get_order() == level) {
+			for (const auto& succ : p_node->get_successors()) {
+				if (succ.get_node() != nullptr && succ.get_node()->get_order() == level + 1) {
+					node_set.insert(succ.get_node());
+				}
 			}
-		};
+		}
+	}
 
+	/// <summary>
+	/// Swap the adjacent levels (level, level + 1) of the weighted node, and return the result.
+	/// Nodes below the two levels are shared, and only the part above them is rebuilt.
+	/// The nodes above keep their number, for the tensors they represent are not changed, so the change
+	/// of the size is counted on the two levels only.
+	/// </summary>
+	/// <param name="w_node"></param>
+	/// <param name="para_shape"></param>
+	/// <param name="inner_data_shape">the inner data shape before swapping</param>
+	/// <param name="level"></param>
+	/// <returns>first: the result, second: the change of the node number</returns>
+	template <class W>
+	std::pair<node::weightednode<W>, int> swap_levels(const node::weightednode<W>& w_node,
+		const std::vector<int64_t>& para_shape,
+		const std::vector<int64_t>& inner_data_shape, int level) {
 
-		template <typename W1, typename W2>
-		using para_coordinator = boost::unordered_map<cache::cont_key<W1, W2>, iter_state<W1, W2>>;
+		boost::unordered_map<node::Node<W>*, node::weightednode<W>> swap_cache{};
 
-		template <typename W1, typename W2>
-		struct Para_Crd {
-			static para_coordinator<W1, W2> record;
-			static std::shared_mutex m;
-		};
+		auto&& res = swap_levels_iterate(w_node, para_shape, inner_data_shape, level, swap_cache);
 
-		/// <summary>
-		/// The mark that the corresponding branch have been calculated already.
-		/// </summary>
-		constexpr int CONT_DONE = (std::numeric_limits<int>::max)();
+		// every node on the two levels reachable before is visited, or is the successor of a visited one
+		boost::unordered_set<const node::Node<W>*> old_nodes, new_nodes;
+		for (const auto& item : swap_cache) {
+			swapped_nodes_collect<W>(item.first, level, old_nodes);
+			swapped_nodes_collect<W>(item.second.get_node(), level, new_nodes);
+		}
+		return std::make_pair(std::move(res), (int)new_nodes.size() - (int)old_nodes.size());
 	}
-	///////////////////////////////////////////////////////////////////////////////
 
 
+	/// <summary>
+	/// Collect the level statistics of the weighted node: the node number at each level, and the width of each cut.
+	/// The cut above level i is crossed by the edges from nodes of order smaller than i to nodes of order no smaller than i,
+	/// and its width is the number of distinct nodes (the terminal included) reached by these edges.
+	/// </summary>
+	/// <param name="w_node"></param>
+	/// <param name="dim_data">the number of levels</param>
+	/// <returns>first: node numbers (of size dim_data), second: cut widths (of size dim_data + 1)</returns>
+	template <class W>
+	std::pair<std::vector<int64_t>, std::vector<int64_t>> level_statistics(const node::weightednode<W>& w_node, int dim_data) {
+		// the minimum order of the parents of each node. -1 for the root.
+		boost::unordered_map<const node::Node<W>*, int> min_parent_order;
+		min_parent_order[w_node.get_node()] = -1;
+
+		std::vector<const node::Node<W>*> node_stack;
+		if (w_node.get_node() != nullptr) {
+			node_stack.push_back(w_node.get_node());
+		}
+		while (!node_stack.empty()) {
+			auto p_node = node_stack.back();
+			node_stack.pop_back();
+			auto order = p_node->get_order();
+			for (const auto& succ : p_node->get_successors()) {
+				auto&& insert_res = min_parent_order.insert(std::make_pair(succ.get_node(), order));
+				if (insert_res.second) {
+					if (succ.get_node() != nullptr) {
+						node_stack.push_back(succ.get_node());
+					}
+				}
+				else if (order < insert_res.first->second) {
+					insert_res.first->second = order;
+				}
+			}
+		}
 
-	class iter_cont {
-	public:
-		/// <summary>
-		/// The sub-program to decide the iteration strategy for parallel methods
-		/// </summary>
-		/// <typeparam name="W1"></typeparam>
-		/// <typeparam name="W2"></typeparam>
-		/// <param name="func"></param>
-		/// <param name="key"></param>
-		/// <param name="range"></param>
-		template <typename W1, typename W2, typename FUNC>
-		inline static void func(std::vector<node::weightednode<weight::W_C<W1, W2>>>& new_successors,
-			const cache::cont_key<W1, W2>& key, int index_range, FUNC const& func) {
-			// exam the parallel coordinator record
-			iter_para::iter_state<W1, W2>* p_iter_state;
-			//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-			iter_para::Para_Crd<W1, W2>::m.lock();
-			auto&& p_find_record = iter_para::Para_Crd<W1, W2>::record.find(key);
-			if (p_find_record == iter_para::Para_Crd<W1, W2>::record.end()) {
-				iter_para::Para_Crd<W1, W2>::record[key].init(index_range);
-				p_find_record = iter_para::Para_Crd<W1, W2>::record.find(key);
+		std::vector<int64_t> counts(dim_data, 0);
+		// a node contributes to the cuts above (min_parent_order, order]
+		std::vector<int64_t> width_diff(dim_data + 2, 0);
+		for (const auto& item : min_parent_order) {
+			int order = dim_data;
+			if (item.first != nullptr) {
+				order = item.first->get_order();
+				counts[order]++;
 			}
-			p_iter_state = &(p_find_record->second);
-			iter_para::Para_Crd<W1, W2>::m.unlock();
-			//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+			width_diff[item.second + 1]++;
+			width_diff[order + 1]--;
+		}
+		std::vector<int64_t> widths(dim_data + 1);
+		int64_t current = 0;
+		for (int i = 0; i <= dim_data; i++) {
+			current += width_diff[i];
+			widths[i] = current;
+		}
+		return std::make_pair(std::move(counts), std::move(widths));
+	}
+
+
+	/// <summary>
+	/// The product of the ranges of levels skipped by the edge from level (from_order) to the node of to_order.
+	/// </summary>
+	inline double skipped_range(const std::vector<int64_t>& inner_data_shape, int from_order, int to_order) noexcept {
+		double res = 1.;
+		for (int i = from_order + 1; i < to_order; i++) {
+			res *= inner_data_shape[i];
+		}
+		return res;
+	}
+
+	/// <summary>
+	/// Calculate the squared norms (as node_norms below does) of the nodes below (including) p_node not recorded in res yet.
+	/// </summary>
+	template <class W>
+	void node_norms_update(const node::Node<W>* p_node, const std::vector<int64_t>& inner_data_shape,
+		boost::unordered_map<const node::Node<W>*, double>& res) {
+		int dim_data = inner_data_shape.size() - 1;
+
+		// post-order traversal
+		std::vector<std::pair<const node::Node<W>*, bool>> node_stack;
+		if (res.find(p_node) == res.end()) {
+			node_stack.push_back(std::make_pair(p_node, false));
+		}
+		while (!node_stack.empty()) {
+			auto item = node_stack.back();
+			node_stack.pop_back();
+			if (res.find(item.first) != res.end()) {
+				continue;
+			}
+			auto&& successors = item.first->get_successors();
+			if (item.second) {
+				double norm2 = 0.;
+				for (const auto& succ : successors) {
+					auto to_order = succ.get_node() == nullptr ? dim_data : succ.get_node()->get_order();
+					norm2 += std::norm(succ.weight) * skipped_range(inner_data_shape, item.first->get_order(), to_order)
+						* res[succ.get_node()];
+				}
+				res[item.first] = norm2;
+			}
+			else {
+				node_stack.push_back(std::make_pair(item.first, true));
+				for (const auto& succ : successors) {
+					if (res.find(succ.get_node()) == res.end()) {
+						node_stack.push_back(std::make_pair(succ.get_node(), false));
+					}
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Calculate the squared norm of every node below (including) w_node, with the root weight excluded.
+	/// The squared norm of the tensor is norm(w_node.weight) * (skipped range) * res[w_node.get_node()].
+	/// Note that the terminal node (nullptr) is recorded with 1.
+	/// </summary>
+	template <class W>
+	boost::unordered_map<const node::Node<W>*, double> node_norms(const node::weightednode<W>& w_node,
+		const std::vector<int64_t>& inner_data_shape) {
+		boost::unordered_map<const node::Node<W>*, double> res;
+		res[nullptr] = 1.;
+		node_norms_update(w_node.get_node(), inner_data_shape, res);
+		return res;
+	}
+
+	/// <summary>
+	/// Calculate the cumulative distribution over the successors of every node below (including) w_node, in which the mass
+	/// of a successor is the squared norm of the elements through it. It is calculated once on the DAG for sampling.
+	/// </summary>
+	template <class W>
+	boost::unordered_map<const node::Node<W>*, std::vector<double>> sample_distributions(const node::weightednode<W>& w_node,
+		const std::vector<int64_t>& inner_data_shape) {
+		int dim_data = inner_data_shape.size() - 1;
+		auto&& norms = node_norms(w_node, inner_data_shape);
+		boost::unordered_map<const node::Node<W>*, std::vector<double>> res;
+		for (const auto& item : norms) {
+			if (item.first == nullptr) {
+				continue;
+			}
+			auto&& successors = item.first->get_successors();
+			std::vector<double> cumulative(successors.size());
+			double total = 0.;
+			for (int i = 0; i < successors.size(); i++) {
+				auto to_order = successors[i].get_node() == nullptr ? dim_data : successors[i].get_node()->get_order();
+				total += std::norm(successors[i].weight) * skipped_range(inner_data_shape, item.first->get_order(), to_order)
+					* norms[successors[i].get_node()];
+				cumulative[i] = total;
+			}
+			res[item.first] = std::move(cumulative);
+		}
+		return res;
+	}
+
+	/// <summary>
+	/// Draw one sample by the random walk from the root to the terminal. The reduced indices are drawn uniformly.
+	/// </summary>
+	/// <param name="distributions">the result of sample_distributions</param>
+	/// <param name="storage_order">to write the sample in the index order of the tensor</param>
+	/// <param name="p_out">the position to write the sample</param>
+	template <class W>
+	void sample_walk(const node::weightednode<W>& w_node, const std::vector<int64_t>& inner_data_shape,
+		const boost::unordered_map<const node::Node<W>*, std::vector<double>>& distributions,
+		const std::vector<int64_t>& storage_order, std::mt19937_64& rng, int64_t* p_out) {
+		int dim_data = inner_data_shape.size() - 1;
+		const node::Node<W>* p_node = w_node.get_node();
+		for (int depth = 0; depth < dim_data; depth++) {
+			int64_t value;
+			if (p_node == nullptr || p_node->get_order() > depth) {
+				value = std::uniform_int_distribution<int64_t>(0, inner_data_shape[depth] - 1)(rng);
+			}
+			else {
+				auto&& cumulative = distributions.find(p_node)->second;
+				auto&& r = std::uniform_real_distribution<double>(0., cumulative.back())(rng);
+				value = std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin();
+				// guard the rounding at the upper end
+				if (value == cumulative.size()) {
+					value--;
+				}
+				p_node = p_node->get_successors()[value].get_node();
+			}
+			p_out[storage_order[depth]] = value;
+		}
+	}
+
+	template <class W>
+	node::weightednode<W> prune_iterate(const node::weightednode<W>& w_node,
+		const boost::unordered_set<const node::Node<W>*>& pruned,
+		boost::unordered_map<node::Node<W>*, node::weightednode<W>>& prune_cache) {
+
+		if (w_node.get_node() == nullptr) {
+			return w_node;
+		}
+
+		if (pruned.find(w_node.get_node()) != pruned.end()) {
+			return node::weightednode<W>{ weight::zeros_like(w_node.weight), nullptr };
+		}
+
+		node::weightednode<W> res;
+
+		// look up in the cache
+		auto&& p_find_res = prune_cache.find(w_node.get_node());
+		if (p_find_res != prune_cache.end()) {
+			res = p_find_res->second;
+			res.weight = weight::mul(res.weight, w_node.weight);
+			return res;
+		}
+
+		auto&& successors = w_node.get_node()->get_successors();
+		node::succ_ls<W> new_successors(successors.size());
+		for (int i = 0; i < successors.size(); i++) {
+			new_successors[i] = wnode::prune_iterate(successors[i], pruned, prune_cache);
+		}
+		res = normalize<W>(weight::ones_like(w_node.weight), w_node.get_node()->get_order(), std::move(new_successors));
+
+		prune_cache[w_node.get_node()] = res;
+
+		res.weight = weight::mul(res.weight, w_node.weight);
+		return res;
+	}
+
+	/// <summary>
+	/// Approximate the weighted node by pruning the nodes of small contributions.
+	/// The contribution of a node is the fraction of the squared norm carried by the paths through it,
+	/// and pruning a node removes exactly these paths (redirected to zero). The nodes contributing less than threshold
+	/// are pruned, and the least contributing nodes are pruned at each level until at most level_budget nodes are left.
+	/// Only the scalar weight is supported, and the tensor weight and exact weight versions return the weighted node unchanged.
+	/// </summary>
+	/// <param name="w_node"></param>
+	/// <param name="inner_data_shape">Note that an *extra dimension* of 2 is needed at the end.</param>
+	/// <param name="threshold">0 for no threshold</param>
+	/// <param name="level_budget">0 for no budget</param>
+	/// <returns>first: the approximated weighted node, second: the loss in fraction of the squared norm.</returns>
+	template <class W>
+	std::pair<node::weightednode<W>, double> approximate(const node::weightednode<W>& w_node,
+		const std::vector<int64_t>& inner_data_shape, double threshold, int64_t level_budget) {
+
+		if constexpr (std::is_same_v<W, CUDAcpl::Tensor> || std::is_same_v<W, weight::qomega>) {
+			return std::make_pair(w_node, 0.);
+		}
+		else {
+			if (w_node.get_node() == nullptr) {
+				return std::make_pair(w_node, 0.);
+			}
+			int dim_data = inner_data_shape.size() - 1;
+
+			// the squared norm below each node
+			auto&& down = node_norms(w_node, inner_data_shape);
+			double total = down[w_node.get_node()];
+			double total_norm = std::norm(w_node.weight) * skipped_range(inner_data_shape, -1, w_node.get_node()->get_order()) * total;
+			if (total_norm <= 0.) {
+				return std::make_pair(w_node, 0.);
+			}
+
+			// the squared norm above each node (the root weight excluded), propagated level by level
+			std::vector<std::vector<const node::Node<W>*>> levels(dim_data);
+			boost::unordered_map<const node::Node<W>*, double> up;
+			for (const auto& item : down) {
+				if (item.first != nullptr) {
+					levels[item.first->get_order()].push_back(item.first);
+					up[item.first] = 0.;
+				}
+			}
+			up[w_node.get_node()] = 1.;
+			for (const auto& level : levels) {
+				for (const auto& p_node : level) {
+					for (const auto& succ : p_node->get_successors()) {
+						if (succ.get_node() != nullptr) {
+							up[succ.get_node()] += up[p_node] * std::norm(succ.weight)
+								* skipped_range(inner_data_shape, p_node->get_order(), succ.get_node()->get_order());
+						}
+					}
+				}
+			}
+
+			// select the nodes to prune. the root is always kept.
+			boost::unordered_set<const node::Node<W>*> pruned;
+			for (auto&& level : levels) {
+				std::vector<std::pair<double, const node::Node<W>*>> contributions;
+				for (const auto& p_node : level) {
+					if (p_node != w_node.get_node()) {
+						contributions.push_back(std::make_pair(up[p_node] * down[p_node] / total, p_node));
+					}
+				}
+				std::sort(contributions.begin(), contributions.end(),
+					[](const std::pair<double, const node::Node<W>*>& a, const std::pair<double, const node::Node<W>*>& b) {
+						return a.first < b.first;
+					});
+				int64_t excess = level_budget > 0 ? (int64_t)level.size() - level_budget : 0;
+				for (int i = 0; i < contributions.size(); i++) {
+					if (i < excess || contributions[i].first < threshold) {
+						pruned.insert(contributions[i].second);
+					}
+					else {
+						break;
+					}
+				}
+			}
+			if (pruned.empty()) {
+				return std::make_pair(w_node, 0.);
+			}
+
+			boost::unordered_map<node::Node<W>*, node::weightednode<W>> prune_cache{};
+			auto&& res = prune_iterate(w_node, pruned, prune_cache);
+
+			// the loss is measured on the result, for the pruned paths may overlap
+			double remained_norm = 0.;
+			if (res.get_node() != nullptr) {
+				remained_norm = std::norm(res.weight) * skipped_range(inner_data_shape, -1, res.get_node()->get_order())
+					* node_norms(res, inner_data_shape)[res.get_node()];
+			}
+			return std::make_pair(std::move(res), (std::max)(0., 1. - remained_norm / total_norm));
+		}
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Iteration Parallelism for cont
+	namespace iter_para {
+		extern ThreadPool* p_thread_pool;
+
+		template <typename W1, typename W2>
+		struct branch_state {
+			int thread_count;
+			node::weightednode<weight::W_C<W1, W2>> w_node;
+
+			branch_state() noexcept {
+				thread_count = 0;
+			}
+		};
+
+		template <typename W1, typename W2>
+		struct iter_state {
+			std::vector<branch_state<W1, W2>> state;
+			std::shared_mutex m;
+
+			void init(int n) noexcept {
+				state.resize(n);
+			}
+		};
+
+
+		template <typename W1, typename W2>
+		using para_coordinator = boost::unordered_map<cache::cont_key<W1, W2>, iter_state<W1, W2>>;
+
+		template <typename W1, typename W2>
+		struct Para_Crd {
+			static para_coordinator<W1, W2> record;
+			static std::shared_mutex m;
+		};
+
+		/// <summary>
+		/// The mark that the corresponding branch have been calculated already.
+		/// </summary>
+		constexpr int CONT_DONE = (std::numeric_limits<int>::max)();
+	}
+	///////////////////////////////////////////////////////////////////////////////
+
+
+
+	class iter_cont {
+	public:
+		/// <summary>
+		/// The sub-program to decide the iteration strategy for parallel methods
+		/// </summary>
+		/// <typeparam name="W1"></typeparam>
+		/// <typeparam name="W2"></typeparam>
+		/// <param name="func"></param>
+		/// <param name="key"></param>
+		/// <param name="range"></param>
+		template <typename W1, typename W2, typename FUNC>
+		inline static void func(node::succ_ls<weight::W_C<W1, W2>>& new_successors,
+			const cache::cont_key<W1, W2>& key, int index_range, FUNC const& func) {
+			// exam the parallel coordinator record
+			iter_para::iter_state<W1, W2>* p_iter_state;
+			//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+			iter_para::Para_Crd<W1, W2>::m.lock();
+			auto&& p_find_record = iter_para::Para_Crd<W1, W2>::record.find(key);
+			if (p_find_record == iter_para::Para_Crd<W1, W2>::record.end()) {
+				iter_para::Para_Crd<W1, W2>::record[key].init(index_range);
+				p_find_record = iter_para::Para_Crd<W1, W2>::record.find(key);
+			}
+			p_iter_state = &(p_find_record->second);
+			iter_para::Para_Crd<W1, W2>::m.unlock();
+			//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
 			bool all_gathered = false;
 			while (!all_gathered) {
@@ -1128,13 +1881,15 @@ namespace wnode {
 		const cache::pair_cmd& a_waiting_ls, const cache::pair_cmd& b_waiting_ls,
 		const std::vector<int64_t>& a_new_order, const std::vector<int64_t>& b_new_order, bool parallel_tensor) {
 
+		ctrl::check();
+
 		if (p_node_a == nullptr && p_node_b == nullptr) {
 			// close all the unprocessed indices
 			double scale = 1.;
 			for (const auto& cmd : remained_ls) {
 				scale *= data_shape_a[cmd.first];
 			}
-			return node::weightednode<weight::W_C<W1, W2>>(weight * scale, nullptr);
+			return node::weightednode<weight::W_C<W1, W2>>(weight::scale(weight, scale), nullptr);
 		}
 
 		node::weightednode<weight::W_C<W1, W2>> res;
@@ -1156,6 +1911,7 @@ namespace wnode {
 			res = p_find_res->second.get_weightednode();
 			cache::Cont_Cache<W1, W2>::cont_cache.first.unlock_shared();
 			//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+			ctrl::count_hit();
 			res.weight = weight::mul(res.weight, weight);
 			return res;
 		}
@@ -1258,10 +2014,10 @@ namespace wnode {
 
 			if (choice_A) {
 				if (a_node_uncontracted) {
-					std::vector<node::weightednode<weight::W_C<W1, W2>>> new_successors;
+					node::succ_ls<weight::W_C<W1, W2>> new_successors;
 					// w_node_a.node will not be null
 					auto&& successors_a = p_node_a->get_successors();
-					new_successors = std::vector<node::weightednode<weight::W_C<W1, W2>>>
+					new_successors = node::succ_ls<weight::W_C<W1, W2>>
 						(data_shape_a[order_a]);
 
 					iter_cont::func(new_successors, key, data_shape_a[order_a],
@@ -1284,10 +2040,10 @@ namespace wnode {
 			}
 			else {
 				if (b_node_uncontracted) {
-					std::vector<node::weightednode<weight::W_C<W1, W2>>> new_successors;
+					node::succ_ls<weight::W_C<W1, W2>> new_successors;
 					// w_node_b.node will not be null
 					auto&& successors_b = p_node_b->get_successors();
-					new_successors = std::vector<node::weightednode<weight::W_C<W1, W2>>>
+					new_successors = node::succ_ls<weight::W_C<W1, W2>>
 						(data_shape_b[order_b]);
 
 					iter_cont::func(new_successors, key, data_shape_b[order_b],
@@ -1313,7 +2069,7 @@ namespace wnode {
 
 			// remained_ls not empty holds in this situation
 			{
-				std::vector<node::weightednode<weight::W_C<W1, W2>>> new_successors;
+				node::succ_ls<weight::W_C<W1, W2>> new_successors;
 				if (order_a >= remained_ls_pd[0].first) {
 					auto&& next_remained_ls = removed(remained_ls_pd, 0);
 
@@ -1323,7 +2079,7 @@ namespace wnode {
 						remained_ls_pd[0].second, 0)
 					);
 
-					new_successors = std::vector<node::weightednode<weight::W_C<W1, W2>>>
+					new_successors = node::succ_ls<weight::W_C<W1, W2>>
 						(data_shape_a[remained_ls_pd[0].first]);
 					if (order_a == remained_ls_pd[0].first) {
 						// w_node_a.node is not null in this case
@@ -1363,7 +2119,7 @@ namespace wnode {
 						remained_ls_pd[next_b_min_i].first, 0)
 					);
 
-					new_successors = std::vector<node::weightednode<weight::W_C<W1, W2>>>
+					new_successors = node::succ_ls<weight::W_C<W1, W2>>
 						(data_shape_b[remained_ls_pd[next_b_min_i].second]);
 					if (order_b == remained_ls_pd[next_b_min_i].second) {
 						// w_node_b.node is not null in this case
@@ -1405,7 +2161,7 @@ namespace wnode {
 
 		RETURN:
 			// add to the cache
-			res.weight = res.weight * scale;
+			res.weight = weight::scale(res.weight, scale);
 
 			//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 			cache::Cont_Cache<W1, W2>::cont_cache.first.lock();
@@ -1419,6 +2175,513 @@ namespace wnode {
 	}
 
 
+	/// <summary>
+	/// The way a frame of the explicit-stack contraction combines the results of its sub-frames.
+	/// </summary>
+	/// <summary>
+	/// The state of the approximated contraction, in which the sub-results are pruned while they are weaved.
+	/// The masses are the squared norms of the sub-results, which are extended constantly over all the levels of the result.
+	/// Only the scalar weight is supported.
+	/// </summary>
+	struct approx_context {
+		double threshold;
+		int64_t level_budget;
+		// the inner shape of the result, with the extra dimension at the end
+		std::vector<int64_t> res_inner_shape;
+		double total_range;
+
+		// the squared norms of the nodes of the operands and of the (approximated) sub-results
+		boost::unordered_map<const node::Node<wcomplex>*, double> norms_a;
+		boost::unordered_map<const node::Node<wcomplex>*, double> norms_b;
+		boost::unordered_map<const node::Node<wcomplex>*, double> norms_res;
+
+		// cover_a[l]: the product of the ranges of the result levels weaved from the levels >= l of a. similar for cover_b.
+		std::vector<double> cover_a;
+		std::vector<double> cover_b;
+
+		// the nodes weaved on each level of the result
+		std::vector<boost::unordered_set<const node::Node<wcomplex>*>> level_nodes;
+
+		// the cache of this contraction, which keeps the approximated sub-results away from the global cache.
+		// second: the estimated mass of the exact sub-result.
+		boost::unordered_map<cache::cont_key<wcomplex, wcomplex>, std::pair<node::weightednode<wcomplex>, double>> results;
+
+		// the estimated mass of the exact result
+		double root_exact_mass;
+
+		approx_context(double _threshold, int64_t _level_budget, const std::vector<int64_t>& _res_inner_shape,
+			const node::weightednode<wcomplex>& w_node_a, const std::vector<int64_t>& data_shape_a,
+			const node::weightednode<wcomplex>& w_node_b, const std::vector<int64_t>& data_shape_b,
+			const cache::pair_cmd& cont_indices) :
+			threshold(_threshold), level_budget(_level_budget), res_inner_shape(_res_inner_shape),
+			total_range(skipped_range(_res_inner_shape, -1, _res_inner_shape.size() - 1)),
+			norms_a(node_norms(w_node_a, data_shape_a)), norms_b(node_norms(w_node_b, data_shape_b)),
+			level_nodes(_res_inner_shape.size() - 1), root_exact_mass(0.) {
+
+			norms_res[nullptr] = 1.;
+			cover_a = covers(data_shape_a, cont_indices, true);
+			cover_b = covers(data_shape_b, cont_indices, false);
+		}
+
+		/// <summary>
+		/// The mass of the (approximated) sub-result.
+		/// </summary>
+		double mass(const node::weightednode<wcomplex>& w_node) {
+			int order = w_node.get_node() == nullptr ? res_inner_shape.size() - 1 : w_node.get_node()->get_order();
+			node_norms_update(w_node.get_node(), res_inner_shape, norms_res);
+			return std::norm(w_node.weight) * skipped_range(res_inner_shape, -1, order) * norms_res[w_node.get_node()];
+		}
+
+	private:
+		static std::vector<double> covers(const std::vector<int64_t>& data_shape, const cache::pair_cmd& cont_indices, bool first) {
+			std::vector<double> res(data_shape.size(), 1.);
+			for (int l = (int)data_shape.size() - 2; l >= 0; l--) {
+				bool contracted = false;
+				for (const auto& cmd : cont_indices) {
+					contracted = contracted || (first ? cmd.first : cmd.second) == l;
+				}
+				res[l] = contracted ? res[l + 1] : res[l + 1] * data_shape[l];
+			}
+			return res;
+		}
+	};
+
+	enum class cont_step {
+		// the only sub-frame result is taken (a waiting index is closed)
+		PASS,
+		// the sub-frame results become the successors of a new node (an uncontracted index is weaved)
+		WEAVE,
+		// the sub-frame results are summed up (a contracted index is opened)
+		SUM
+	};
+
+	/// <summary>
+	/// The frame of the explicit-stack contraction, corresponding to one invocation of contract_iterate.
+	/// </summary>
+	template <typename W1, typename W2>
+	struct cont_frame {
+		// the arguments
+		const node::Node<W1>* p_node_a;
+		const node::Node<W2>* p_node_b;
+		weight::W_C<W1, W2> weight;
+		cache::pair_cmd remained_ls;
+		cache::pair_cmd a_waiting_ls;
+		cache::pair_cmd b_waiting_ls;
+
+		// the state after expansion
+		bool expanded;
+		std::unique_ptr<cache::cont_key<W1, W2>> p_key;
+		double scale;
+		cont_step step;
+		int new_order;
+		std::vector<cont_frame<W1, W2>> sub_frames;
+		node::succ_ls<weight::W_C<W1, W2>> results;
+
+		// only for the approximated contraction: the estimated masses of the exact sub-results and of the exact result
+		std::vector<double> exact_masses;
+		double exact_mass;
+
+		cont_frame(const node::Node<W1>* _p_node_a, const node::Node<W2>* _p_node_b, weight::W_C<W1, W2>&& _weight,
+			const cache::pair_cmd& _remained_ls, const cache::pair_cmd& _a_waiting_ls, const cache::pair_cmd& _b_waiting_ls) :
+			p_node_a(_p_node_a), p_node_b(_p_node_b), weight(std::move(_weight)),
+			remained_ls(_remained_ls), a_waiting_ls(_a_waiting_ls), b_waiting_ls(_b_waiting_ls),
+			expanded(false), scale(1.), step(cont_step::PASS), new_order(0), exact_mass(0.) {}
+	};
+
+	/// <summary>
+	/// Expand the frame as contract_iterate does: look up the cache, decide the step and prepare the sub-frames.
+	/// Return true if the result is obtained at once, which is stored in res.
+	/// </summary>
+	template <typename W1, typename W2>
+	bool cont_frame_expand(cont_frame<W1, W2>& frame, node::weightednode<weight::W_C<W1, W2>>& res,
+		const std::vector<int64_t>& para_shape_a, const std::vector<int64_t>& para_shape_b,
+		const std::vector<int64_t>& para_shape_res,
+		const std::vector<int64_t>& data_shape_a, const std::vector<int64_t>& data_shape_b,
+		const std::vector<int64_t>& a_new_order, const std::vector<int64_t>& b_new_order, bool parallel_tensor,
+		approx_context* p_approx) {
+
+		ctrl::check();
+		frame.expanded = true;
+
+		auto p_node_a = frame.p_node_a;
+		auto p_node_b = frame.p_node_b;
+
+		if (p_node_a == nullptr && p_node_b == nullptr) {
+			// close all the unprocessed indices
+			double scale = 1.;
+			for (const auto& cmd : frame.remained_ls) {
+				scale *= data_shape_a[cmd.first];
+			}
+			res = node::weightednode<weight::W_C<W1, W2>>(weight::scale(frame.weight, scale), nullptr);
+			if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+				if (p_approx) {
+					frame.exact_mass = std::norm(res.weight) * p_approx->total_range;
+				}
+			}
+			return true;
+		}
+
+		int order_a = p_node_a == nullptr ? data_shape_a.size() - 1 : p_node_a->get_order();
+		int order_b = p_node_b == nullptr ? data_shape_b.size() - 1 : p_node_b->get_order();
+		frame.p_key = std::make_unique<cache::cont_key<W1, W2>>(p_node_a, para_shape_a, p_node_b, para_shape_b, frame.remained_ls,
+			frame.a_waiting_ls, frame.b_waiting_ls, a_new_order, order_a, b_new_order, order_b, parallel_tensor);
+
+		if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+			if (p_approx) {
+				auto&& p_find_res = p_approx->results.find(*frame.p_key);
+				if (p_find_res != p_approx->results.end()) {
+					ctrl::count_hit();
+					res = p_find_res->second.first;
+					res.weight = weight::mul(res.weight, frame.weight);
+					frame.exact_mass = p_find_res->second.second * std::norm(frame.weight);
+					return true;
+				}
+			}
+		}
+
+		if (!p_approx) {
+			//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+			cache::Cont_Cache<W1, W2>::cont_cache.first.lock_shared();
+			auto&& p_find_res = cache::Cont_Cache<W1, W2>::cont_cache.second.find(*frame.p_key);
+			if (p_find_res != cache::Cont_Cache<W1, W2>::cont_cache.second.end()) {
+				res = p_find_res->second.get_weightednode();
+				cache::Cont_Cache<W1, W2>::cont_cache.first.unlock_shared();
+				//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+				ctrl::count_hit();
+				res.weight = weight::mul(res.weight, frame.weight);
+				return true;
+			}
+			cache::Cont_Cache<W1, W2>::cont_cache.first.unlock_shared();
+			//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+		}
+
+		bool a_node_uncontracted = true, b_node_uncontracted = true;
+		int next_b_min_i = 0;
+		auto&& remained_ls_pd = cache::pair_cmd();
+		for (const auto& cmd : frame.remained_ls) {
+			if (cmd.first < order_a && cmd.second < order_b) {
+				frame.scale *= data_shape_a[cmd.first];
+			}
+			else {
+				if (cmd.first == order_a) {
+					a_node_uncontracted = false;
+				}
+				if (cmd.second == order_b) {
+					b_node_uncontracted = false;
+				}
+				remained_ls_pd.push_back(cmd);
+				if (cmd.second < remained_ls_pd[next_b_min_i].second) {
+					next_b_min_i = remained_ls_pd.size() - 1;
+				}
+			}
+		}
+
+		auto&& a_waiting_ls_pd = cache::pair_cmd();
+		for (const auto& cmd : frame.a_waiting_ls) {
+			if (cmd.first >= order_a) {
+				a_waiting_ls_pd.push_back(cmd);
+				if (cmd.first == order_a) {
+					a_node_uncontracted = false;
+				}
+			}
+		}
+
+		auto&& b_waiting_ls_pd = cache::pair_cmd();
+		for (const auto& cmd : frame.b_waiting_ls) {
+			if (cmd.first >= order_b) {
+				b_waiting_ls_pd.push_back(cmd);
+				if (cmd.first == order_b) {
+					b_node_uncontracted = false;
+				}
+			}
+		}
+
+		auto&& unit = weight::ones_like(frame.weight);
+		auto& sub_frames = frame.sub_frames;
+
+		// first try to close the waited indices
+		if (!a_waiting_ls_pd.empty() && order_a == a_waiting_ls_pd[0].first) {
+			auto&& succ = p_node_a->get_successors()[a_waiting_ls_pd[0].second];
+			sub_frames.emplace_back(succ.get_node(), p_node_b,
+				weight::weight_expanded_back<W1, W2>(succ.weight, para_shape_res, parallel_tensor),
+				remained_ls_pd, removed(a_waiting_ls_pd, 0), b_waiting_ls_pd);
+			frame.step = cont_step::PASS;
+			return false;
+		}
+		if (!b_waiting_ls_pd.empty() && order_b == b_waiting_ls_pd[0].first) {
+			auto&& succ = p_node_b->get_successors()[b_waiting_ls_pd[0].second];
+			sub_frames.emplace_back(p_node_a, succ.get_node(),
+				weight::weight_expanded_front<W1, W2>(succ.weight, para_shape_res, parallel_tensor),
+				remained_ls_pd, a_waiting_ls_pd, removed(b_waiting_ls_pd, 0));
+			frame.step = cont_step::PASS;
+			return false;
+		}
+
+		// then try to weave the nodes of uncontracted indices
+		bool choice_A;
+		if (p_node_a == nullptr) {
+			choice_A = false;
+		}
+		else if (p_node_b == nullptr) {
+			choice_A = true;
+		}
+		else {
+			choice_A = a_new_order[order_a] < b_new_order[order_b];
+		}
+
+		if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+			if (p_approx && p_approx->level_budget > 0 && ((choice_A && a_node_uncontracted) || (!choice_A && b_node_uncontracted))) {
+				int new_order = choice_A ? a_new_order[order_a] : b_new_order[order_b];
+				if ((int64_t)p_approx->level_nodes[new_order].size() >= p_approx->level_budget) {
+					// the level is full, so that a new node here would be pruned. skip the sub-result, and bound its mass
+					// by the Cauchy-Schwarz inequality.
+					double bound = frame.scale * frame.scale * p_approx->norms_a[p_node_a] * p_approx->norms_b[p_node_b]
+						* p_approx->total_range / (p_approx->cover_a[order_a] * p_approx->cover_b[order_b]);
+					for (const auto& cmd : remained_ls_pd) {
+						if (cmd.first < order_a) {
+							bound *= data_shape_a[cmd.first];
+						}
+						if (cmd.second < order_b) {
+							bound *= data_shape_b[cmd.second];
+						}
+					}
+					p_approx->results[*frame.p_key] = std::make_pair(
+						node::weightednode<wcomplex>(weight::zeros_like(unit), nullptr), bound);
+					res = node::weightednode<wcomplex>(weight::zeros_like(unit), nullptr);
+					frame.exact_mass = bound * std::norm(frame.weight);
+					return true;
+				}
+			}
+		}
+
+		if (choice_A && a_node_uncontracted) {
+			for (const auto& succ : p_node_a->get_successors()) {
+				sub_frames.emplace_back(succ.get_node(), p_node_b,
+					weight::weight_expanded_back<W1, W2>(succ.weight, para_shape_res, parallel_tensor),
+					remained_ls_pd, a_waiting_ls_pd, b_waiting_ls_pd);
+			}
+			frame.step = cont_step::WEAVE;
+			frame.new_order = a_new_order[order_a];
+			return false;
+		}
+		if (!choice_A && b_node_uncontracted) {
+			for (const auto& succ : p_node_b->get_successors()) {
+				sub_frames.emplace_back(p_node_a, succ.get_node(),
+					weight::weight_expanded_front<W1, W2>(succ.weight, para_shape_res, parallel_tensor),
+					remained_ls_pd, a_waiting_ls_pd, b_waiting_ls_pd);
+			}
+			frame.step = cont_step::WEAVE;
+			frame.new_order = b_new_order[order_b];
+			return false;
+		}
+
+		// remained_ls not empty holds in this situation, and a contracted index is opened
+		frame.step = cont_step::SUM;
+		if (order_a >= remained_ls_pd[0].first) {
+			auto&& next_remained_ls = removed(remained_ls_pd, 0);
+			int insert_pos = get_cmd_insert_pos(b_waiting_ls_pd, remained_ls_pd[0].second);
+			auto&& next_b_waiting_ls = inserted(b_waiting_ls_pd, insert_pos, std::make_pair(remained_ls_pd[0].second, 0));
+
+			int range = data_shape_a[remained_ls_pd[0].first];
+			for (int i = 0; i < range; i++) {
+				next_b_waiting_ls[insert_pos].second = i;
+				if (order_a == remained_ls_pd[0].first) {
+					auto&& succ = p_node_a->get_successors()[i];
+					sub_frames.emplace_back(succ.get_node(), p_node_b,
+						weight::weight_expanded_back<W1, W2>(succ.weight, para_shape_res, parallel_tensor),
+						next_remained_ls, a_waiting_ls_pd, next_b_waiting_ls);
+				}
+				else {
+					// this node skipped the opening index in this case
+					sub_frames.emplace_back(p_node_a, p_node_b, weight::W_C<W1, W2>(unit),
+						next_remained_ls, a_waiting_ls_pd, next_b_waiting_ls);
+				}
+			}
+		}
+		else {
+			auto&& next_remained_ls = removed(remained_ls_pd, next_b_min_i);
+			int insert_pos = get_cmd_insert_pos(a_waiting_ls_pd, remained_ls_pd[next_b_min_i].first);
+			auto&& next_a_waiting_ls = inserted(a_waiting_ls_pd, insert_pos, std::make_pair(remained_ls_pd[next_b_min_i].first, 0));
+
+			int range = data_shape_b[remained_ls_pd[next_b_min_i].second];
+			for (int i = 0; i < range; i++) {
+				next_a_waiting_ls[insert_pos].second = i;
+				if (order_b == remained_ls_pd[next_b_min_i].second) {
+					auto&& succ = p_node_b->get_successors()[i];
+					sub_frames.emplace_back(p_node_a, succ.get_node(),
+						weight::weight_expanded_front<W1, W2>(succ.weight, para_shape_res, parallel_tensor),
+						next_remained_ls, next_a_waiting_ls, b_waiting_ls_pd);
+				}
+				else {
+					// this node skipped the opening index in this case
+					sub_frames.emplace_back(p_node_a, p_node_b, weight::W_C<W1, W2>(unit),
+						next_remained_ls, next_a_waiting_ls, b_waiting_ls_pd);
+				}
+			}
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Combine the sub-results of the resolved frame in the approximated contraction, and record the result in the context.
+	/// The sub-results of a weaved node carrying less than threshold of its mass are pruned, and so is the new node if its
+	/// level is full already. The mass of the exact result is estimated along, in which the sum of the sub-results is
+	/// assumed to keep the ratio of the approximated mass to the exact mass.
+	/// Return the result without the frame weight, and set frame.exact_mass with the frame weight.
+	/// </summary>
+	inline node::weightednode<wcomplex> approx_finalize(cont_frame<wcomplex, wcomplex>& frame, approx_context& context) {
+		node::weightednode<wcomplex> res;
+		double exact_mass = 0.;
+		if (frame.step == cont_step::PASS) {
+			res = std::move(frame.results[0]);
+			exact_mass = frame.exact_masses[0];
+		}
+		else if (frame.step == cont_step::WEAVE) {
+			std::vector<double> masses(frame.results.size());
+			double total = 0.;
+			for (int i = 0; i < frame.results.size(); i++) {
+				masses[i] = context.mass(frame.results[i]);
+				total += masses[i];
+				exact_mass += frame.exact_masses[i];
+			}
+			exact_mass /= context.res_inner_shape[frame.new_order];
+			for (int i = 0; i < frame.results.size(); i++) {
+				if (masses[i] > 0. && masses[i] < context.threshold * total) {
+					frame.results[i] = node::weightednode<wcomplex>(weight::zeros_like(frame.results[i].weight), nullptr);
+				}
+			}
+			res = normalize<wcomplex>(weight::ones_like(frame.weight), frame.new_order, std::move(frame.results));
+			// the node is not weaved here if the successors are reduced
+			if (res.get_node() != nullptr && res.get_node()->get_order() == frame.new_order) {
+				auto& level = context.level_nodes[frame.new_order];
+				if (level.find(res.get_node()) == level.end()) {
+					if (context.level_budget > 0 && (int64_t)level.size() >= context.level_budget) {
+						res = node::weightednode<wcomplex>(weight::zeros_like(res.weight), nullptr);
+					}
+					else {
+						level.insert(res.get_node());
+					}
+				}
+			}
+		}
+		else {
+			double total = 0.;
+			res = frame.results[0];
+			for (int i = 0; i < frame.results.size(); i++) {
+				if (i > 0) {
+					res = sum<wcomplex>(res, frame.results[i], std::vector<int64_t>());
+				}
+				total += context.mass(frame.results[i]);
+				exact_mass += frame.exact_masses[i];
+			}
+			if (total > 0.) {
+				exact_mass *= context.mass(res) / total;
+			}
+		}
+		res.weight = weight::scale(res.weight, frame.scale);
+		exact_mass *= frame.scale * frame.scale;
+
+		context.results[*frame.p_key] = std::make_pair(res, exact_mass);
+		frame.exact_mass = exact_mass * std::norm(frame.weight);
+		return res;
+	}
+
+	/// <summary>
+	/// Contract the two weighted nodes with an explicit frame stack instead of recursion, so that the depth of the network
+	/// is not limited by the thread stack. It produces the same results and shares the cache with contract_iterate,
+	/// but runs on the calling thread only.
+	/// The parameters are the same as contract_iterate.
+	/// With p_approx given, the sub-results are pruned as they are weaved (see contract_approx), and the approximation
+	/// context is used as the cache instead.
+	/// The garbage is collected periodically during the contraction if check_garbage is true.
+	/// </summary>
+	/// <returns></returns>
+	template <typename W1, typename W2>
+	node::weightednode<weight::W_C<W1, W2>> contract_stack(
+		const node::Node<W1>* p_node_a, const std::vector<int64_t>& para_shape_a,
+		const node::Node<W2>* p_node_b, const std::vector<int64_t>& para_shape_b,
+		const weight::W_C<W1, W2>& weight,
+		const std::vector<int64_t>& para_shape_res,
+		const std::vector<int64_t>& data_shape_a, const std::vector<int64_t>& data_shape_b,
+		const cache::pair_cmd& remained_ls,
+		const std::vector<int64_t>& a_new_order, const std::vector<int64_t>& b_new_order, bool parallel_tensor,
+		approx_context* p_approx = nullptr, bool check_garbage = true) {
+
+		std::vector<cont_frame<W1, W2>> frames;
+		frames.emplace_back(p_node_a, p_node_b, weight::W_C<W1, W2>(weight), remained_ls, cache::pair_cmd(), cache::pair_cmd());
+
+		node::weightednode<weight::W_C<W1, W2>> res;
+		auto last_check = std::chrono::steady_clock::now();
+		while (true) {
+			auto& frame = frames.back();
+			bool done = false;
+			if (!frame.expanded) {
+				auto&& now = std::chrono::steady_clock::now();
+				if (check_garbage && now - last_check > mng::garbage_check_period.load()) {
+					mng::cache_clear_check();
+					last_check = now;
+				}
+
+				done = cont_frame_expand<W1, W2>(frame, res, para_shape_a, para_shape_b, para_shape_res,
+					data_shape_a, data_shape_b, a_new_order, b_new_order, parallel_tensor, p_approx);
+			}
+			if (!done) {
+				if (frame.results.size() < frame.sub_frames.size()) {
+					// descend into the next sub-frame. note that the reference to frame is invalidated hereafter.
+					cont_frame<W1, W2> sub_frame{ std::move(frame.sub_frames[frame.results.size()]) };
+					frames.push_back(std::move(sub_frame));
+					continue;
+				}
+
+				// all the sub-frames are resolved
+				if constexpr (std::is_same_v<W1, wcomplex> && std::is_same_v<W2, wcomplex>) {
+					if (p_approx) {
+						res = approx_finalize(frame, *p_approx);
+					}
+				}
+				if (!p_approx) {
+					if (frame.step == cont_step::PASS) {
+						res = std::move(frame.results[0]);
+					}
+					else if (frame.step == cont_step::WEAVE) {
+						res = normalize<weight::W_C<W1, W2>>(weight::ones_like(frame.weight), frame.new_order, std::move(frame.results));
+					}
+					else {
+						res = frame.results[0];
+						for (auto&& i = frame.results.begin() + 1; i != frame.results.end(); i++) {
+							res = sum<weight::W_C<W1, W2>>(res, *i, para_shape_res);
+						}
+					}
+					res.weight = weight::scale(res.weight, frame.scale);
+
+					// add to the cache
+					//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+					cache::Cont_Cache<W1, W2>::cont_cache.first.lock();
+					cache::Cont_Cache<W1, W2>::cont_cache.second[*frame.p_key] = res;
+					cache::Cont_Cache<W1, W2>::cont_cache.first.unlock();
+					//<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+				}
+
+				res.weight = weight::mul(res.weight, frame.weight);
+			}
+
+			// return the result to the parent frame
+			double exact_mass = frame.exact_mass;
+			frames.pop_back();
+			if (frames.empty()) {
+				if (p_approx) {
+					p_approx->root_exact_mass = exact_mass;
+				}
+				return res;
+			}
+			frames.back().results.push_back(std::move(res));
+			if (p_approx) {
+				frames.back().exact_masses.push_back(exact_mass);
+			}
+		}
+	}
+
+
 	/// <summary>
 	/// contract the designated indices, on w_node_a and w_node_b
 	/// </summary>
@@ -1450,12 +2713,24 @@ namespace wnode {
 			});
 
 
+		auto prepared_weight = weight::prepare_weight(w_node_a.weight, w_node_b.weight, parallel_tensor);
+
+		// deep networks are contracted with the explicit frame stack on this thread, to avoid overflowing the thread stacks
+		if ((int64_t)(data_shape_a.size() + data_shape_b.size()) > mng::stack_cont_depth.load()) {
+			return contract_stack<W1, W2>(
+				w_node_a.get_node(), para_shape_a,
+				w_node_b.get_node(), para_shape_b,
+				prepared_weight,
+				para_shape_res,
+				data_shape_a, data_shape_b, sorted_remained_ls,
+				a_new_order, b_new_order, parallel_tensor);
+		}
+
 		std::vector<std::future<node::weightednode<weight::W_C<W1, W2>>>> results(iter_para::p_thread_pool->thread_num());
 
-		auto prepared_weight = weight::prepare_weight(w_node_a.weight, w_node_b.weight, parallel_tensor);
 		for (int i = 0; i < iter_para::p_thread_pool->thread_num(); i++) {
 			results[i] = iter_para::p_thread_pool->enqueue(
-				[&] {
+				ctrl::bind([&] {
 					auto && res = contract_iterate<W1, W2>(
 						w_node_a.get_node(), para_shape_a,
 						w_node_b.get_node(), para_shape_b,
@@ -1464,22 +2739,84 @@ namespace wnode {
 						data_shape_a, data_shape_b, sorted_remained_ls, cache::pair_cmd(), cache::pair_cmd(),
 						a_new_order, b_new_order, parallel_tensor);
 					return res;
-				}
+				})
 			);
 		}
 
 		while (results[0].wait_for(mng::garbage_check_period.load()) != std::future_status::ready) {
 			mng::cache_clear_check();
+			// examine the limits and report the progress on this thread
+			ctrl::poll();
 		}
 
-		auto&& res = results[0].get();
-
-		for (int i = 1; i < results.size(); i++) {
-			results[i].get();
+		// all the tasks must finish before leaving, for they refer to the local variables here.
+		node::weightednode<weight::W_C<W1, W2>> res;
+		std::exception_ptr p_exception = nullptr;
+		for (int i = 0; i < results.size(); i++) {
+			try {
+				auto&& temp = results[i].get();
+				if (i == 0) {
+					res = std::move(temp);
+				}
+			}
+			catch (...) {
+				if (!p_exception) {
+					p_exception = std::current_exception();
+				}
+			}
 		}
 
 		iter_para::Para_Crd<W1, W2>::record.clear();
 
+		if (p_exception) {
+			std::rethrow_exception(p_exception);
+		}
+
 		return res;
 	}
+
+	/// <summary>
+	/// Contract the designated indices as contract does, and prune the sub-results while they are weaved, so that both
+	/// the size and the time are limited. It runs on the calling thread with the explicit frame stack, and the global
+	/// cache is neither used nor affected.
+	/// A weaved node drops the successors carrying less than threshold of its mass, and the new nodes of the levels which
+	/// already hold level_budget nodes are pruned, without their sub-results calculated.
+	/// Only the scalar weight is supported.
+	/// </summary>
+	/// <param name="res_inner_shape">the inner shape of the result. Note that an *extra dimension* of 2 is needed at the end.</param>
+	/// <param name="threshold">0 for no threshold</param>
+	/// <param name="level_budget">0 for no budget</param>
+	/// <returns>first: the approximated weighted node, second: the estimated fidelity (fraction of the squared norm kept).</returns>
+	inline std::pair<node::weightednode<wcomplex>, double> contract_approx(
+		const node::weightednode<wcomplex>& w_node_a, const node::weightednode<wcomplex>& w_node_b,
+		const std::vector<int64_t>& data_shape_a, const std::vector<int64_t>& data_shape_b,
+		const cache::pair_cmd& cont_indices,
+		const std::vector<int64_t>& a_new_order, const std::vector<int64_t>& b_new_order,
+		const std::vector<int64_t>& res_inner_shape, double threshold, int64_t level_budget) {
+
+		cache::pair_cmd sorted_remained_ls(cont_indices);
+		std::sort(sorted_remained_ls.begin(), sorted_remained_ls.end(),
+			[](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+				return (a.first < b.first);
+			});
+
+		approx_context context(threshold, level_budget, res_inner_shape,
+			w_node_a, data_shape_a, w_node_b, data_shape_b, sorted_remained_ls);
+
+		auto&& empty_shape = std::vector<int64_t>();
+		auto&& res = contract_stack<wcomplex, wcomplex>(
+			w_node_a.get_node(), empty_shape,
+			w_node_b.get_node(), empty_shape,
+			weight::prepare_weight(w_node_a.weight, w_node_b.weight, false),
+			empty_shape,
+			data_shape_a, data_shape_b, sorted_remained_ls,
+			a_new_order, b_new_order, false, &context);
+
+		double fidelity = 1.;
+		if (context.root_exact_mass > 0.) {
+			fidelity = (std::min)(1., context.mass(res) / context.root_exact_mass);
+		}
+		return std::make_pair(std::move(res), fidelity);
+	}
+
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+import numpy as np
+import time
+import random
+
+import tddpy
+from tddpy import TDD
+
+
+def random_qubit_gates(width: int, depth: int) -> list:
+    '''
+        random layers of single-qubit rotations and cx gates, so that every node of the tdd is of range 2.
+    '''
+    gates = []
+    for layer in range(depth):
+        for q in range(width):
+            gates.append(("rz", [q], [random.uniform(0, 2*np.pi)]))
+            gates.append(("h", [q]))
+        for q in range(layer % 2, width - 1, 2):
+            gates.append(("cx", [q, q+1]))
+    return gates
+
+if __name__ == "__main__":
+    # run once with the current build and once with the build to compare against
+    width_max = 12
+    depth = 8
+    repeat = 10
+    with open("r_qubit_d{}.csv".format(depth),"w") as pfile:
+        pfile.write("cir_width, time, size\n")
+
+        for width in range(2, width_max+1):
+            for i in range(repeat):
+                gates = random_qubit_gates(width, depth)
+                tddpy.reset()
+                t0 = time.perf_counter()
+                res = TDD.circuit(width, gates, state=True)
+                t1 = time.perf_counter()
+                pfile.write("{}, {}, {}\n".format(width, t1 - t0, res.size()))
+                print("{}, {}, {}".format(width, t1 - t0, res.size()))
@@ -1,5 +1,6 @@
 from .tdd import TDD
-from .global_method import test, clear_garbage, clear_cache, get_config, reset
+from .global_method import test, clear_garbage, clear_cache, get_config, reset, set_stack_cont_depth
+from .control import Controller, Cancelled
 from . import CUDAcpl
 
 # coordinators for tensor network
@@ -0,0 +1,85 @@
+from __future__ import annotations
+from typing import Callable, Dict, Optional
+
+from . import ctdd
+
+# raised when an operation supervised by a controller is aborted
+Cancelled = ctdd.Cancelled
+
+
+class Controller:
+    '''
+        The controller of long-running operations (tensordot, trace, sum and as_tensor).
+
+        time_limit: the wall-clock limit in seconds. 0 for no limit.
+        node_limit: the limit of nodes newly created in the operation. 0 for no limit.
+        callback: called as callback(nodes_created, cache_hits, elapsed) periodically on the calling thread.
+            The operation is cancelled if it returns False.
+        report_period: the period (in seconds) to invoke the callback.
+        approx_threshold: if not 0, the nodes of contraction results contributing less than this fraction
+            of the squared norm are pruned.
+        level_budget: if not 0, at most this number of nodes are kept at each level of contraction results.
+            The pruning takes place during the contraction, which limits its time and memory.
+            Only the TDDs of scalar weights can be approximated.
+        sift_threshold: if not 0, the contraction results with more nodes than this are reordered by sifting
+            (so their storage order differs from the usual one).
+
+        An aborted operation raises tddpy.Cancelled.
+        The GIL is released during the operations, so they can be cancelled from other python threads.
+        The fidelity accumulated over the approximated contractions is reported in progress["fidelity"].
+            It is an estimate, for the exact results are not calculated.
+    '''
+
+    # the reasons for the abortion
+    REASONS = ("none", "cancelled", "time limit", "node limit", "callback")
+
+    def __init__(self, time_limit: float = 0., node_limit: int = 0,
+                 callback: Optional[Callable[[int, int, float], bool]] = None, report_period: float = 0.5,
+                 approx_threshold: float = 0., level_budget: int = 0, sift_threshold: int = 0):
+        self._pointer : int = ctdd.controller_new(float(time_limit), int(node_limit), float(report_period), callback,
+                                                  float(approx_threshold), int(level_budget), int(sift_threshold))
+
+    @property
+    def pointer(self) -> int:
+        return self._pointer
+
+    def cancel(self) -> None:
+        '''
+            Cancel the supervised operation. The cancellation stays valid until reset() is called.
+        '''
+        ctdd.controller_cancel(self._pointer)
+
+    def reset(self) -> None:
+        '''
+            Clear the cancellation and the accumulated fidelity.
+        '''
+        ctdd.controller_reset(self._pointer)
+
+    @property
+    def progress(self) -> Dict:
+        '''
+            The progress of the (last) supervised operation.
+        '''
+        res = ctdd.controller_progress(self._pointer)
+        res["reason"] = Controller.REASONS[res["reason"]]
+        return res
+
+    @property
+    def cancelled(self) -> bool:
+        return self.progress["cancelled"]
+
+    @property
+    def fidelity(self) -> float:
+        return self.progress["fidelity"]
+
+    def __del__(self):
+        if ctdd:
+            if ctdd.controller_delete:
+                ctdd.controller_delete(self._pointer)
+
+
+def controller_pointer(controller: Optional[Controller]) -> int:
+    '''
+        Return the pointer passed to the C++ backend. 0 for no control.
+    '''
+    return 0 if controller is None else controller.pointer
@@ -19,13 +19,26 @@ def clear_cache() -> None:
 def get_config() -> None:
     return ctdd.get_config()
 
+def set_stack_cont_depth(depth: int) -> None:
+    '''
+        Contractions with more levels (of both operands in total) than depth are conducted with the explicit frame stack
+        on the calling thread, instead of the recursive parallel iteration. 0 for always.
+    '''
+    ctdd.set_stack_cont_depth(int(depth))
+    GlobalVar.current_config = get_config()
+
 
 # the current configuration of kernel is recorded
 class GlobalVar:
     current_config = get_config()
 
-def reset(thread_num:int = 4, device_cuda: bool = False, dtype_double: bool = True, eps = 3E-7,
+def reset(thread_num:int = 4, device_cuda: bool = False, dtype_double: bool = True, eps = None,
                   gc_check_period = 0.5, vmem_limit_MB: int = 5000) -> None:
+    '''
+        eps: None for the default of the kernel, which depends on the precision of scalar weights.
+    '''
+    if eps is None:
+        eps = GlobalVar.current_config["default EPS"]
     ctdd.reset(thread_num, device_cuda, dtype_double, eps, gc_check_period, vmem_limit_MB)
     CUDAcpl.Config.setting_update(device_cuda, dtype_double)
 
@@ -1,6 +1,7 @@
 
 from __future__ import annotations
-from typing import Any, Dict, Tuple, List, Union, Sequence;
+from typing import Any, Callable, Dict, Tuple, List, Union, Sequence;
+import concurrent.futures
 import numpy as np
 import torch
 
@@ -16,75 +17,163 @@ from .node import Node
 # the global configuration
 from .global_method import GlobalVar
 
+# the controller of long-running operations
+from .control import Controller, Cancelled, controller_pointer
+
 # for tdd graphing
 from graphviz import Digraph
 from IPython.display import Image
 
 TERMINAL_ID = -1
 
-class TDD:
+def _async_call(operands: List) -> Tuple[concurrent.futures.Future, Callable]:
+    '''
+        Prepare the future and the completion callable of an asynchronous operation.
+        The operands (tdds and the controller) are kept alive until the operation finishes.
+    '''
+    future = concurrent.futures.Future()
+    future.set_running_or_notify_cancel()
+
+    def done(pointer: int, tensor_weight: bool, error: int, message: str):
+        operands.clear()
+        if error == 0:
+            future.set_result(TDD(pointer, tensor_weight))
+        elif error == 1:
+            future.set_exception(Cancelled(message))
+        else:
+            future.set_exception(ValueError(message))
+
+    return future, done
+
+def _in_place_buffer(array: np.ndarray) -> bool:
+    '''
+        Whether the complex128 array can be read and written in place by the backend,
+        i.e. it is aligned to double and its strides are non-negative multiples of 8 bytes.
+    '''
+    return array.ctypes.data % 8 == 0 and all(s >= 0 and s % 8 == 0 for s in array.strides)
+
+class TDD(ctdd.TDDBase):
+    '''
+        The tdd tensor, constructed as TDD(pointer, tensor_weight) from the pointer returned by ctdd.
+        The tdd is held inline by the native base (ctdd.TDDBase), which also provides the properties
+        pointer and tensor_weight, and the methods size, conj, permute and slice without python overhead.
+    '''
 
     para_check = True
 
+    # the information is fetched lazily, for the tdds created by the native methods
+    _info = None
+
     # different invocations for scalar and tensor weight
     def get_tdd_info(self):
-        if self._tensor_weight:
-            return ctdd.get_tdd_info_T(self._pointer)
+        if self.tensor_weight:
+            return ctdd.get_tdd_info_T(self.pointer)
         else:
             return ctdd.get_tdd_info(self.pointer)
 
-
-    def __init__(self, pointer, tensor_weight: bool):
-        self._pointer : int = pointer
-        self._tensor_weight = tensor_weight
-        self._info = self.get_tdd_info()
-
     @staticmethod
     def check_parameter(check: bool) -> None:
         TDD.para_check = check
 
-    @property
-    def tensor_weight(self)->bool:
-        return self._tensor_weight
-
-    @property
-    def pointer(self) -> int:
-        return self._pointer
-
     @property
     def node(self) -> Node:
-        return Node(self._info["node"], self._tensor_weight)
+        return Node(self.info["node"], self.tensor_weight)
 
     @property
     def info(self) -> Dict:
+        if self._info is None:
+            self._info = self.get_tdd_info()
         return self._info
 
     @property
     def shape(self) -> Tuple:
-        return self._info["data shape"]
+        return self.info["data shape"]
     
     @property
     def parallel_shape(self) -> Tuple:
-        return self._info["parallel shape"]
+        return self.info["parallel shape"]
 
     @property
     def storage_order(self) -> Tuple:
-        return self._info["storage order"]
+        return self.info["storage order"]
 
-    def size(self) -> int:
-        if self._tensor_weight:
-            return ctdd.get_tdd_size_T(self._pointer)
+    def swap_levels(self, level: int) -> None:
+        '''
+            Swap the inner levels (level, level + 1) in place. The tensor represented is not changed,
+            while the storage order is updated.
+        '''
+        if TDD.para_check:
+            if level < 0 or level >= len(self.shape) - 1:
+                raise Exception("The level must be an integer from 0 to "+str(len(self.shape) - 2)+".")
+        if self.tensor_weight:
+            ctdd.swap_levels_T(self.pointer, level)
         else:
-            return ctdd.get_tdd_size(self._pointer)
+            ctdd.swap_levels(self.pointer, level)
+        self._info = None
 
-    def CUDAcpl(self) -> CplTensor:
-        if self._tensor_weight:
-            return ctdd.to_CUDAcpl_T(self._pointer)
+    def sift(self, max_growth: float = 1.2) -> int:
+        '''
+            Reorder the inner levels in place by sifting, to reduce the size. Return the size after reordering.
+            max_growth: the maximum size growth (ratio) allowed when moving an index.
+        '''
+        if self.tensor_weight:
+            res = ctdd.sift_T(self.pointer, float(max_growth))
+        else:
+            res = ctdd.sift(self.pointer, float(max_growth))
+        self._info = None
+        return res
+
+    def CUDAcpl(self, out: CplTensor|None = None) -> CplTensor:
+        '''
+            out: if given, the amplitudes are written into it directly, without intermediate tensors.
+                It should be on cpu, contiguous, of a floating type and of the shape of the result, and it is returned.
+        '''
+        if out is not None:
+            if self.tensor_weight:
+                ctdd.to_CUDAcpl_into_T(self.pointer, out)
+            else:
+                ctdd.to_CUDAcpl_into(self.pointer, out)
+            return out
+
+        if self.tensor_weight:
+            return ctdd.to_CUDAcpl_T(self.pointer)
         else:
-            return ctdd.to_CUDAcpl(self._pointer)
+            return ctdd.to_CUDAcpl(self.pointer)
 
-    def numpy(self) -> np.ndarray:
-        return CUDAcpl.CUDAcpl2np(self.CUDAcpl())
+    def numpy(self, out: np.ndarray|None = None) -> np.ndarray:
+        '''
+            out: if given, the complex numpy array to write the amplitudes into directly, and it is returned.
+            For the scalar weight tdd, the amplitudes are written into the complex128 buffer without intermediate tensors.
+        '''
+        if self.tensor_weight:
+            if out is not None:
+                self.CUDAcpl(torch.view_as_real(torch.from_numpy(out)))
+                return out
+            return CUDAcpl.CUDAcpl2np(self.CUDAcpl())
+
+        if out is None:
+            out = np.empty(self.shape, dtype = np.complex128)
+        if out.dtype == np.complex128 and _in_place_buffer(out):
+            ctdd.to_buffer(self.pointer, out)
+        elif out.dtype == np.complex128:
+            out[...] = self.numpy()
+        else:
+            self.CUDAcpl(torch.view_as_real(torch.from_numpy(out)))
+        return out
+
+    def sample(self, num_samples: int, seed: int|None = None, controller: Controller|None = None) -> torch.Tensor:
+        '''
+            Draw samples of the index values (e.g. the measurement outcomes of a state), with the probability
+            proportional to the squared magnitude of the elements, without the dense tensor.
+            The samples are reproducible for the same seed. (scalar weight tdd only)
+
+            return: the int64 tensor of shape (num_samples, dim_data).
+        '''
+        if self.tensor_weight:
+            raise Exception("Sampling is only supported for the scalar weight tdd.")
+        if seed is None:
+            seed = int(np.random.randint(0, 2**63, dtype=np.int64))
+        return ctdd.sample(self.pointer, num_samples, seed, controller_pointer(controller))
 
     def __str__(self):
         return str(self.numpy())
@@ -124,21 +213,12 @@ class TDD:
         return Image(dot.render(path))
 
 
-    def __del__(self):
-        if ctdd:
-            if self._tensor_weight:
-                if ctdd.delete_tdd_T:
-                    ctdd.delete_tdd_T(self._pointer)
-            else:
-                if ctdd.delete_tdd:
-                    ctdd.delete_tdd(self._pointer)
-
-
     # the tensor methods
 
     @staticmethod
     def as_tensor(data : TDD|
-                      CplTensor|np.ndarray|Tuple[CplTensor|np.ndarray, int, Sequence[int]]) -> TDD:
+                      CplTensor|np.ndarray|Tuple[CplTensor|np.ndarray, int, Sequence[int]],
+                      controller: Controller|None = None, _done: Callable|None = None) -> TDD:
 
         '''
         construct the tdd tensor
@@ -153,12 +233,14 @@ class TDD:
                 Note that if the input matrix is a torch tensor, 
                         then it must be already in CplTensor(CUDA complex) form.
 
+        controller: the controller to supervise this operation.
+        _done: (internal) the completion callable of the asynchronous variant, which returns None instead.
         '''
 
         # pre-process
         if isinstance(data, TDD):
             # note the order information is also copied
-            if data._tensor_weight:
+            if data.tensor_weight:
                 return TDD(ctdd.as_tensor_clone_T(data.pointer), True)
             else:
                 return TDD(ctdd.as_tensor_clone(data.pointer), False)
@@ -170,19 +252,30 @@ class TDD:
             parallel_i_num = 0
             storage_order = []
             
+        from_buffer = False
         if isinstance(tensor,np.ndarray):
-            tensor = CUDAcpl.np2CUDAcpl(tensor)
+            if parallel_i_num == 0 and _done is None:
+                # the complex128 buffer is read in place by the backend
+                tensor = np.asarray(tensor, dtype = np.complex128)
+                if not _in_place_buffer(tensor):
+                    tensor = tensor.copy()
+                from_buffer = True
+            else:
+                tensor = CUDAcpl.np2CUDAcpl(tensor)
+        elif tensor.is_complex():
+            tensor = torch.view_as_real(tensor)
 
         # examination
         if (TDD.para_check):
             # check dtype and device
-            if (tensor.dtype == torch.float64) != GlobalVar.current_config["dtype double"]:
-                raise Exception("The dtype of provided tensor does not match the current configurations.")
-            if (tensor.device == torch.device('cpu')) != (not GlobalVar.current_config["device cuda"]):
-                raise Exception("The device of provided tensor does not match the current configurations.")
+            if not from_buffer:
+                if (tensor.dtype == torch.float64) != GlobalVar.current_config["dtype double"]:
+                    raise Exception("The dtype of provided tensor does not match the current configurations.")
+                if (tensor.device == torch.device('cpu')) != (not GlobalVar.current_config["device cuda"]):
+                    raise Exception("The device of provided tensor does not match the current configurations.")
 
             # check shape and order
-            data_shape = list(tensor.shape[:-1])
+            data_shape = list(tensor.shape) if from_buffer else list(tensor.shape[:-1])
             if len(data_shape) < parallel_i_num:
                 raise Exception("Parallel index number must not exceed the dimension of input tensor.")
             if len(data_shape)!=len(storage_order) + parallel_i_num and len(storage_order)!=0:
@@ -200,24 +293,74 @@ class TDD:
 
         tensor_weight = (parallel_i_num != 0)
 
-        if tensor_weight:
-            pointer = ctdd.as_tensor_T(tensor, parallel_i_num, storage_order)
+        ctrl_pointer = controller_pointer(controller)
+        if from_buffer:
+            pointer = ctdd.as_buffer(tensor, list(storage_order), ctrl_pointer)
+        elif tensor_weight:
+            pointer = ctdd.as_tensor_T(tensor, parallel_i_num, storage_order, ctrl_pointer, _done)
         else:
-            pointer = ctdd.as_tensor(tensor, 0, storage_order)
+            pointer = ctdd.as_tensor(tensor, 0, storage_order, ctrl_pointer, _done)
 
+        if _done is not None:
+            return None
         return TDD(pointer, tensor_weight)
 
-    def conj(self: TDD) -> TDD:
+    @staticmethod
+    def as_sparse(data: torch.Tensor|Tuple[torch.Tensor|np.ndarray, torch.Tensor|np.ndarray, Sequence[int]],
+                  storage_order: Sequence[int] = [],
+                  controller: Controller|None = None) -> TDD:
         '''
-            Return the conjugate of the tdd tensor.
-            # note that the coordinator information is not changed.
+        construct the scalar weight tdd from the sparse tensor in the COO format, without the dense tensor.
+
+        data:
+            1. a torch sparse COO tensor of the complex dtype.
+            2. a tuple (indices, values, shape), where indices is of shape (nnz, dim), and values are the nnz complex values.
+            The values of duplicated coordinates are summed up.
+
+        controller: the controller to supervise this operation.
         '''
-        if self._tensor_weight:
-            pointer = ctdd.conj_T(self.pointer)
+        if isinstance(data, torch.Tensor):
+            indices = data._indices().T
+            values = data._values()
+            shape = list(data.shape)
         else:
-            pointer = ctdd.conj(self.pointer)
+            indices, values, shape = data
+            indices = torch.as_tensor(indices)
+            values = torch.as_tensor(values)
+            shape = list(shape)
 
-        return TDD(pointer, self.tensor_weight)
+        indices = indices.to(torch.int64).reshape((-1, len(shape)))
+        values = torch.view_as_real(values.to(torch.complex128).reshape(-1))
+
+        pointer = ctdd.as_sparse(indices, values, shape, list(storage_order), controller_pointer(controller))
+        return TDD(pointer, False)
+
+    @staticmethod
+    def circuit(num_qubits: int, gates: Sequence[Tuple],
+                state: bool = False, controller: Controller|None = None) -> TDD:
+        '''
+        simulate the whole circuit in C++, and return the scalar weight tdd of the unitary
+        (or of the state from |0...0> if state is True).
+
+        gates: the gates in order, each a tuple (matrix, qubits) or (matrix, qubits, params), where matrix is
+            1. the name of the gate (e.g. "h", "cx", "rz"), with the parameters in params.
+            2. the matrix of the gate, as a complex numpy array, a complex torch tensor or a CUDAcpl tensor.
+
+        controller: the controller to supervise this operation.
+        '''
+        gates_ls = []
+        for gate in gates:
+            matrix, qubits = gate[0], gate[1]
+            params = gate[2] if len(gate) > 2 else []
+            if not isinstance(matrix, str):
+                if isinstance(matrix, torch.Tensor) and not matrix.is_complex():
+                    matrix = matrix.to(torch.double)
+                else:
+                    matrix = torch.view_as_real(torch.as_tensor(matrix).to(torch.complex128))
+            gates_ls.append((matrix, list(qubits), [float(p) for p in params]))
+
+        pointer = ctdd.circuit(num_qubits, gates_ls, state, controller_pointer(controller))
+        return TDD(pointer, False)
 
     @staticmethod
     def mul(tensor: TDD, scalar: CplTensor|complex) -> TDD:
@@ -225,7 +368,7 @@ class TDD:
             Return the tdd multiplied by the scalar (tensor).
             Note that the coordinator information will not be changed.
         '''
-        if tensor._tensor_weight:
+        if tensor.tensor_weight:
             if isinstance(scalar, complex):
                 pointer = ctdd.mul_TW(tensor.pointer, scalar)
             elif isinstance (scalar, CplTensor):
@@ -238,12 +381,17 @@ class TDD:
             else:
                 raise "The scalar must be a python complex for this scalar weight tdd."
 
-        return TDD(pointer, tensor._tensor_weight)
+        return TDD(pointer, tensor.tensor_weight)
 
     def __add__(self, other: TDD) -> TDD:
+        return self.add(other)
+
+    def add(self: TDD, other: TDD, controller: Controller|None = None, _done: Callable|None = None) -> TDD:
         '''
             return the summation of two tdds
             Note that the coordinator information is not changed.
+            controller: the controller to supervise this operation.
+            _done: (internal) the completion callable of the asynchronous variant, which returns None instead.
         '''
         # examination
         if TDD.para_check:
@@ -254,15 +402,19 @@ class TDD:
         # examination done
 
         if self.tensor_weight:
-            pointer = ctdd.sum_T(self.pointer, other.pointer)
+            pointer = ctdd.sum_T(self.pointer, other.pointer, controller_pointer(controller), _done)
         else:
-            pointer = ctdd.sum_W(self.pointer, other.pointer)
+            pointer = ctdd.sum_W(self.pointer, other.pointer, controller_pointer(controller), _done)
 
-        return TDD(pointer, self._tensor_weight)
+        if _done is not None:
+            return None
+        return TDD(pointer, self.tensor_weight)
 
-    def trace(self: TDD, axes:Sequence[Sequence[int]]) -> TDD:
+    def trace(self: TDD, axes:Sequence[Sequence[int]], controller: Controller|None = None, _done: Callable|None = None) -> TDD:
         '''
             Trace the TDD at given indices.
+            controller: the controller to supervise this operation.
+            _done: (internal) the completion callable of the asynchronous variant, which returns None instead.
         '''
 
         # examination
@@ -280,50 +432,28 @@ class TDD:
                 repeat[axes[1][i]] = True
         # examination done
 
+        ctrl_pointer = controller_pointer(controller)
         if self.tensor_weight:
-            pointer = ctdd.trace_T(self.pointer, list(axes[0]), list(axes[1]))
-        else:
-            pointer = ctdd.trace(self.pointer, list(axes[0]), list(axes[1]))
-
-        return TDD(pointer, self.tensor_weight)
-
-    def slice(self: TDD, indices: Sequence[int], values: Sequence[int]) -> TDD:
-        '''
-            slice the TDD at given indices.
-        '''
-
-        # examination
-        if TDD.para_check:
-            if len(indices) != len(values):
-                raise Exception("The indices given by parameter axes does not match.")
-            dim = len(self.shape)
-            repeat = [False]*dim
-            for i in range(len(indices)):
-                if indices[i] < 0 or indices[i] >= dim:
-                    raise Exception('Elements in axes must be integers from 0 to '+str(dim-1)+'.')
-                if repeat[indices[i]]:
-                    raise Exception('Elements in axes must not repeat.')
-                repeat[indices[i]] = True
-                if values[i] < 0 or values[i] >= self.shape[i]:
-                    raise Exception('Error: Index value.')
-        # examination done
-
-        if self.tensor_weight:
-            pointer = ctdd.slice_T(self.pointer, list(indices), list(values))
+            pointer = ctdd.trace_T(self.pointer, list(axes[0]), list(axes[1]), ctrl_pointer, _done)
         else:
-            pointer = ctdd.slice(self.pointer, list(indices), list(values))
+            pointer = ctdd.trace(self.pointer, list(axes[0]), list(axes[1]), ctrl_pointer, _done)
 
+        if _done is not None:
+            return None
         return TDD(pointer, self.tensor_weight)
 
     @staticmethod
     def tensordot(a: TDD, b: TDD, 
                   axes: int|Sequence[Sequence[int]], rearrangement: Sequence[bool] = [],
-                  parallel_tensor: bool = False) -> TDD:
+                  parallel_tensor: bool = False, controller: Controller|None = None,
+                  _done: Callable|None = None) -> TDD:
         
         '''
             The pytorch-like tensordot method. Note that indices should be counted with data indices only.
             rearrangement: If not [], then will rearrange according to the parameter. Otherwise, it will rearrange according to the coordinator.
             parallel_tensor: Whether to tensor on the parallel indices.
+            controller: the controller to supervise this operation. tddpy.Cancelled is raised if it is aborted.
+            _done: (internal) the completion callable of the asynchronous variant, which returns None instead.
         '''
 
         # examination
@@ -363,21 +493,21 @@ class TDD:
                     raise Exception('The provided rearrangement is not valid.')
         # examination done
 
-
+        ctrl_pointer = controller_pointer(controller)
 
         if isinstance(axes, int):
             # conditioning on the weight version and iteration parallelism
             if not a.tensor_weight and not b.tensor_weight:
-                pointer = ctdd.tensordot_num_WW(a.pointer, b.pointer, axes, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_num_WW(a.pointer, b.pointer, axes, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = False
             elif a.tensor_weight and b.tensor_weight:
-                pointer = ctdd.tensordot_num_TT(a.pointer, b.pointer, axes, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_num_TT(a.pointer, b.pointer, axes, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = True
             elif a.tensor_weight and not b.tensor_weight:
-                pointer = ctdd.tensordot_num_TW(a.pointer, b.pointer, axes, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_num_TW(a.pointer, b.pointer, axes, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = True
             else:
-                pointer = ctdd.tensordot_num_WT(a.pointer, b.pointer, axes, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_num_WT(a.pointer, b.pointer, axes, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = True
 
         else:
@@ -386,38 +516,242 @@ class TDD:
             
             # conditioning on the weight version and iteration parallelism
             if not a.tensor_weight and not b.tensor_weight:
-                pointer = ctdd.tensordot_ls_WW(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_ls_WW(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = False
             elif a.tensor_weight and b.tensor_weight:
-                pointer = ctdd.tensordot_ls_TT(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_ls_TT(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = True
             elif a.tensor_weight and not b.tensor_weight:
-                pointer = ctdd.tensordot_ls_TW(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_ls_TW(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = True
             else:
-                pointer = ctdd.tensordot_ls_WT(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor)
+                pointer = ctdd.tensordot_ls_WT(a.pointer, b.pointer, i1, i2, rearrangement, parallel_tensor, ctrl_pointer, _done)
                 res_tensor_weight = True
         
+        if _done is not None:
+            return None
         res = TDD(pointer, res_tensor_weight)
         return res
 
+    @staticmethod
+    def tensordot_sliced(a: TDD, b: TDD,
+                         axes: int|Sequence[Sequence[int]], indices: Sequence[int], values: Sequence[int],
+                         rearrangement: Sequence[bool] = [],
+                         parallel_tensor: bool = False, controller: Controller|None = None) -> TDD:
+        '''
+            Return tensordot(a, b, axes) sliced on the given result indices, which are fixed to the given values.
+            The slicing is pushed down to a and b before contracting, so that only the sub-tensor required is calculated.
+            indices: counted in the indices of the unsliced result.
+            rearrangement: the rearrangement of the unsliced result.
+            Other parameters are the same as tensordot.
+        '''
+        if isinstance(axes, int):
+            i1 = list(range(len(a.shape) - axes, len(a.shape)))
+            i2 = list(range(axes))
+        else:
+            i1 = list(axes[0])
+            i2 = list(axes[1])
 
-    def permute(self: TDD, perm: Sequence[int]) -> TDD:
         # examination
         if TDD.para_check:
-            dim = len(self.shape)
-            if len(perm) != dim:
-                raise Exception("Given permutation is not valid.")
-            repeat = [False]*dim
-            for i in perm:
-                if i < 0 or i >= dim:
-                    raise Exception("Elements in the given permutation must be from 0 to "+str(dim-1)+".")
-                if repeat[i]:
-                    raise Exception("Elements in the given permutation must not repeat.")
-                repeat[i] = True
+            dim_res = len(a.shape) + len(b.shape) - 2 * len(i1)
+            if len(indices) != len(values):
+                raise Exception("The indices and values given does not match.")
+            for i in range(len(indices)):
+                if indices[i] < 0 or indices[i] >= dim_res:
+                    raise Exception("Elements in indices must be integers from 0 to "+str(dim_res-1)+".")
         # examination done
 
-        if self.tensor_weight:
-            return TDD(ctdd.permute_T(self.pointer, list(perm)), True);
+        ctrl_pointer = controller_pointer(controller)
+        indices = list(indices)
+        values = list(values)
+        rearrangement = list(rearrangement)
+
+        if not a.tensor_weight and not b.tensor_weight:
+            pointer = ctdd.tensordot_sliced_WW(a.pointer, b.pointer, i1, i2, indices, values, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = False
+        elif a.tensor_weight and b.tensor_weight:
+            pointer = ctdd.tensordot_sliced_TT(a.pointer, b.pointer, i1, i2, indices, values, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+        elif a.tensor_weight and not b.tensor_weight:
+            pointer = ctdd.tensordot_sliced_TW(a.pointer, b.pointer, i1, i2, indices, values, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+        else:
+            pointer = ctdd.tensordot_sliced_WT(a.pointer, b.pointer, i1, i2, indices, values, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+
+        return TDD(pointer, res_tensor_weight)
+
+    @staticmethod
+    def tensordot_trace(a: TDD, b: TDD,
+                        axes: int|Sequence[Sequence[int]], trace_axes: Sequence[Sequence[int]],
+                        rearrangement: Sequence[bool] = [],
+                        parallel_tensor: bool = False, controller: Controller|None = None) -> TDD:
+        '''
+            Return tensordot(a, b, axes) traced on trace_axes, without producing the untraced result.
+            trace_axes: the pairs of indices to trace, counted in the indices of the untraced result.
+            rearrangement: the rearrangement of the untraced result.
+            Other parameters are the same as tensordot.
+        '''
+        if isinstance(axes, int):
+            i1 = list(range(len(a.shape) - axes, len(a.shape)))
+            i2 = list(range(axes))
+        else:
+            i1 = list(axes[0])
+            i2 = list(axes[1])
+
+        # examination
+        if TDD.para_check:
+            if len(trace_axes[0]) != len(trace_axes[1]):
+                raise Exception("The indices given by parameter trace_axes does not match.")
+            dim_res = len(a.shape) + len(b.shape) - 2 * len(i1)
+            repeat = [False]*dim_res
+            for i in range(len(trace_axes[0])):
+                if trace_axes[0][i] < 0 or trace_axes[0][i] >= dim_res or trace_axes[1][i] < 0 or trace_axes[1][i] >= dim_res:
+                    raise Exception('Elements in trace_axes must be integers from 0 to '+str(dim_res-1)+'.')
+                if repeat[trace_axes[0][i]] or repeat[trace_axes[1][i]]:
+                    raise Exception('Elements in trace_axes must not repeat.')
+                repeat[trace_axes[0][i]] = True
+                repeat[trace_axes[1][i]] = True
+        # examination done
+
+        ctrl_pointer = controller_pointer(controller)
+        t1 = list(trace_axes[0])
+        t2 = list(trace_axes[1])
+        rearrangement = list(rearrangement)
+
+        if not a.tensor_weight and not b.tensor_weight:
+            pointer = ctdd.tensordot_trace_WW(a.pointer, b.pointer, i1, i2, t1, t2, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = False
+        elif a.tensor_weight and b.tensor_weight:
+            pointer = ctdd.tensordot_trace_TT(a.pointer, b.pointer, i1, i2, t1, t2, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+        elif a.tensor_weight and not b.tensor_weight:
+            pointer = ctdd.tensordot_trace_TW(a.pointer, b.pointer, i1, i2, t1, t2, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+        else:
+            pointer = ctdd.tensordot_trace_WT(a.pointer, b.pointer, i1, i2, t1, t2, rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+
+        return TDD(pointer, res_tensor_weight)
+
+    @staticmethod
+    def tensordot_hsf(a: TDD, b: TDD,
+                      axes: int|Sequence[Sequence[int]], slice_budget: float = 1e6,
+                      rearrangement: Sequence[bool] = [],
+                      parallel_tensor: bool = False, controller: Controller|None = None) -> TDD:
+        '''
+            Return tensordot(a, b, axes), calculated in the hybrid Schrodinger-Feynman way: contracted index pairs
+            are sliced until the estimated node number of one slice fits in slice_budget, the slices are contracted
+            on separate threads, and the results are summed up.
+            slice_budget: the maximum estimated node number (see estimate_tensordot) of one slice.
+            Other parameters are the same as tensordot.
+        '''
+        if isinstance(axes, int):
+            i1 = list(range(len(a.shape) - axes, len(a.shape)))
+            i2 = list(range(axes))
         else:
-            return TDD(ctdd.permute(self.pointer, list(perm)), False);
+            i1 = list(axes[0])
+            i2 = list(axes[1])
+
+        # examination
+        if TDD.para_check:
+            if len(i1) != len(i2):
+                raise Exception("The indices given by parameter axes does not match.")
+            if slice_budget <= 0:
+                raise Exception("The slice budget must be positive.")
+        # examination done
+
+        ctrl_pointer = controller_pointer(controller)
+        rearrangement = list(rearrangement)
+
+        if not a.tensor_weight and not b.tensor_weight:
+            pointer = ctdd.tensordot_hsf_WW(a.pointer, b.pointer, i1, i2, float(slice_budget), rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = False
+        elif a.tensor_weight and b.tensor_weight:
+            pointer = ctdd.tensordot_hsf_TT(a.pointer, b.pointer, i1, i2, float(slice_budget), rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+        elif a.tensor_weight and not b.tensor_weight:
+            pointer = ctdd.tensordot_hsf_TW(a.pointer, b.pointer, i1, i2, float(slice_budget), rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+        else:
+            pointer = ctdd.tensordot_hsf_WT(a.pointer, b.pointer, i1, i2, float(slice_budget), rearrangement, parallel_tensor, ctrl_pointer)
+            res_tensor_weight = True
+
+        return TDD(pointer, res_tensor_weight)
+
+    @staticmethod
+    def estimate_tensordot(a: TDD, b: TDD,
+                           axes: int|Sequence[Sequence[int]], rearrangement: Sequence[bool] = [],
+                           parallel_tensor: bool = False) -> Dict:
+        '''
+            Estimate the cost of tensordot without executing it. The parameters are the same as tensordot.
+            Return a dictionary with the items:
+                "level nodes": the predicted node number at each level of the result,
+                "nodes": the predicted node number of the result,
+                "work": the predicted number of contraction steps,
+                "time": the predicted time (in second, single thread).
+        '''
+        if isinstance(axes, int):
+            i1 = list(range(len(a.shape) - axes, len(a.shape)))
+            i2 = list(range(axes))
+        else:
+            i1 = list(axes[0])
+            i2 = list(axes[1])
+
+        if not a.tensor_weight and not b.tensor_weight:
+            return ctdd.estimate_tensordot_WW(a.pointer, b.pointer, i1, i2, list(rearrangement), parallel_tensor)
+        elif a.tensor_weight and b.tensor_weight:
+            return ctdd.estimate_tensordot_TT(a.pointer, b.pointer, i1, i2, list(rearrangement), parallel_tensor)
+        elif a.tensor_weight and not b.tensor_weight:
+            return ctdd.estimate_tensordot_TW(a.pointer, b.pointer, i1, i2, list(rearrangement), parallel_tensor)
+        else:
+            return ctdd.estimate_tensordot_WT(a.pointer, b.pointer, i1, i2, list(rearrangement), parallel_tensor)
+
+    # the asynchronous variants
+
+    @staticmethod
+    def as_tensor_async(data : TDD|
+                      CplTensor|np.ndarray|Tuple[CplTensor|np.ndarray, int, Sequence[int]],
+                      controller: Controller|None = None) -> concurrent.futures.Future:
+        '''
+            The asynchronous variant of as_tensor, which returns the future of the tdd immediately.
+            The operations are executed one at a time on the dispatcher thread of the backend, while this thread goes on.
+            Use asyncio.wrap_future to await the result in asyncio.
+        '''
+        if isinstance(data, TDD):
+            future = concurrent.futures.Future()
+            future.set_result(TDD.as_tensor(data))
+            return future
+        future, done = _async_call([data, controller])
+        TDD.as_tensor(data, controller, _done = done)
+        return future
+
+    def add_async(self: TDD, other: TDD, controller: Controller|None = None) -> concurrent.futures.Future:
+        '''
+            The asynchronous variant of add, which returns the future of the tdd immediately.
+        '''
+        future, done = _async_call([self, other, controller])
+        self.add(other, controller, _done = done)
+        return future
+
+    def trace_async(self: TDD, axes:Sequence[Sequence[int]], controller: Controller|None = None) -> concurrent.futures.Future:
+        '''
+            The asynchronous variant of trace, which returns the future of the tdd immediately.
+        '''
+        future, done = _async_call([self, controller])
+        self.trace(axes, controller, _done = done)
+        return future
+
+    @staticmethod
+    def tensordot_async(a: TDD, b: TDD,
+                  axes: int|Sequence[Sequence[int]], rearrangement: Sequence[bool] = [],
+                  parallel_tensor: bool = False, controller: Controller|None = None) -> concurrent.futures.Future:
+        '''
+            The asynchronous variant of tensordot, which returns the future of the tdd immediately.
+            For example, independent contractions can be overlapped in asyncio as
+                await asyncio.gather(*[asyncio.wrap_future(TDD.tensordot_async(a, b, 1)) for a, b in pairs])
+        '''
+        future, done = _async_call([a, b, controller])
+        TDD.tensordot(a, b, axes, rearrangement, parallel_tensor, controller, _done = done)
+        return future
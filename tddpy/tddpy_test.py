@@ -1,8 +1,9 @@
 
+import asyncio
 import numpy as np
 import torch
 from torch._C import dtype
-from tddpy import TDD, CUDAcpl, GlobalOrderCoordinator
+from tddpy import TDD, CUDAcpl, GlobalOrderCoordinator, Controller, Cancelled, clear_cache, get_config, set_stack_cont_depth
 
 def compare(title, expected: CUDAcpl.CplTensor,
             actual: CUDAcpl.CplTensor):
@@ -291,6 +292,315 @@ def test11():
 
     compare("test11", expected, actual)
 
+def test12():
+    '''
+    controlled contraction
+    '''
+    a = torch.rand((2,2,2,2,2,2,2), dtype = torch.double)
+    b = torch.rand((2,2,2,2,2,2,2), dtype = torch.double)
+    expected = CUDAcpl.tensordot(a, b, 3)
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    clear_cache()
+    actual = TDD.tensordot(a_tdd, b_tdd, 3, controller = Controller(time_limit = 60.)).CUDAcpl()
+
+    compare("test12", expected, actual)
+
+    clear_cache()
+    try:
+        TDD.tensordot(a_tdd, b_tdd, 3, controller = Controller(node_limit = 1))
+        print("not passed: test12 node limit")
+    except Cancelled:
+        print("passed: test12 node limit")
+
+def test13():
+    '''
+    contraction cost estimation
+    '''
+    # the outer product of two generic 2x2 tensors: the levels of b are shared under every path of a,
+    # so the result has 1, 2 nodes on the levels of a and 1, 2 nodes on the levels of b
+    a = torch.rand((2,2,2), dtype = torch.double)
+    b = torch.rand((2,2,2), dtype = torch.double)
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    estimate = TDD.estimate_tensordot(a_tdd, b_tdd, 0)
+    expected = torch.tensor([1., 2., 1., 2.], dtype = torch.double)
+    actual = torch.tensor(estimate["level nodes"], dtype = torch.double)
+    compare("test13 level nodes", expected, actual)
+    compare("test13 nodes", torch.tensor(6., dtype = torch.double), torch.tensor(estimate["nodes"], dtype = torch.double))
+
+    # the estimation does not change the operands
+    expected = CUDAcpl.tensordot(a, b, 0)
+    actual = TDD.tensordot(a_tdd, b_tdd, 0).CUDAcpl()
+    compare("test13 tensordot", expected, actual)
+
+def test14():
+    '''
+    level swapping and sifting
+    '''
+    a = torch.rand((2,3,2,4,2), dtype = torch.double)
+    a_tdd = TDD.as_tensor(a)
+
+    a_tdd.swap_levels(1)
+    compare("test14 swap", a, a_tdd.CUDAcpl())
+
+    size = a_tdd.sift()
+    compare("test14 sift", a, a_tdd.CUDAcpl())
+    # the size followed through the swaps matches the recount
+    compare("test14 sift size", torch.tensor(float(a_tdd.size())), torch.tensor(float(size)))
+
+    # the results are sifted only under a controller asking for it
+    b = torch.rand((4,2,2), dtype = torch.double)
+    expected = CUDAcpl.tensordot(a, b, 1)
+    actual_tdd = TDD.tensordot(a_tdd, TDD.as_tensor(b), 1, controller = Controller(sift_threshold = 1))
+    compare("test14 sift controller", expected, actual_tdd.CUDAcpl())
+
+def test15():
+    '''
+    approximate contraction
+    '''
+    a = torch.rand((2,2,2,2,2,2), dtype = torch.double)
+    b = torch.rand((2,2,2,2,2,2), dtype = torch.double)
+    expected = CUDAcpl.CUDAcpl2np(CUDAcpl.tensordot(a, b, 0)).flatten()
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    controller = Controller(level_budget = 2)
+    actual = CUDAcpl.CUDAcpl2np(TDD.tensordot(a_tdd, b_tdd, 0, controller = controller).CUDAcpl()).flatten()
+
+    # the fidelity reported is an estimate in general, but it is exact for the outer product.
+    # it should agree with the one of the results
+    fidelity = abs(np.vdot(expected, actual))**2 / np.vdot(expected, expected).real / np.vdot(actual, actual).real
+    if abs(fidelity - controller.fidelity) < 1e-6:
+        print("passed: test15, fidelity: ", fidelity)
+    else:
+        print("not passed: test15, fidelity: ", fidelity, controller.fidelity)
+
+def test16():
+    '''
+    sliced contraction
+    '''
+    a = torch.rand((2,3,4,2), dtype = torch.double)
+    b = torch.rand((4,3,2,2), dtype = torch.double)
+    expected = CUDAcpl.tensordot(a, b, [[2],[0]])[1,:,:,0]
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    actual = TDD.tensordot_sliced(a_tdd, b_tdd, [[2],[0]], [0,3], [1,0]).CUDAcpl()
+
+    compare("test16", expected, actual)
+
+def test17():
+    '''
+    fused contraction and trace
+    '''
+    a = torch.rand((2,3,2,4,2), dtype = torch.double)
+    b = torch.rand((4,3,2,5,2,2), dtype = torch.double)
+    expected = CUDAcpl.einsum("iciq,qcjkj->k", a, b)
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    # (0,2): inside a, (1,3): across a and b, (4,6): inside b
+    actual = TDD.tensordot_trace(a_tdd, b_tdd, [[3],[0]], [[0,1,4],[2,3,6]]).CUDAcpl()
+
+    compare("test17", expected, actual)
+
+def test18():
+    '''
+    contraction with the explicit frame stack
+    '''
+    a = torch.rand((2,2,3,2,2,2), dtype = torch.double)
+    b = torch.rand((2,3,2,2,2), dtype = torch.double)
+    expected = CUDAcpl.tensordot(a, b, [[1,2],[0,1]])
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    depth = get_config()["stack cont depth"]
+    set_stack_cont_depth(0)
+    clear_cache()
+    actual = TDD.tensordot(a_tdd, b_tdd, [[1,2],[0,1]]).CUDAcpl()
+    set_stack_cont_depth(depth)
+
+    compare("test18", expected, actual)
+
+def test19():
+    '''
+    hybrid Schrodinger-Feynman contraction
+    '''
+    a = torch.rand((2,3,2,2,2), dtype = torch.double)
+    b = torch.rand((2,3,2,2,2), dtype = torch.double)
+    expected = CUDAcpl.tensordot(a, b, [[1,2,3],[1,0,2]])
+
+    a_tdd = TDD.as_tensor(a)
+    b_tdd = TDD.as_tensor(b)
+    # a tiny budget forces all the contracted pairs to be sliced
+    actual = TDD.tensordot_hsf(a_tdd, b_tdd, [[1,2,3],[1,0,2]], slice_budget = 1).CUDAcpl()
+
+    compare("test19", expected, actual)
+
+def test20():
+    '''
+    as_tensor with repeated sub-blocks, non-contiguous input and storage order
+    '''
+    block = torch.rand((3,2,2), dtype = torch.double)
+    a = torch.stack([block, block, torch.zeros_like(block), block], 0).reshape((2,2,3,2,2))
+    a = a.transpose(1,2)
+    expected = a
+
+    actual = TDD.as_tensor((a, 0, [3,1,0,2])).CUDAcpl()
+
+    compare("test20", expected, actual)
+
+def test21():
+    '''
+    direct write into the output buffer
+    '''
+    a = torch.rand((2,3,2,2,2), dtype = torch.double)
+    expected = a
+
+    a_tdd = TDD.as_tensor((a, 0, [2,0,3,1]))
+    actual = torch.empty((2,3,2,2,2), dtype = torch.double)
+    a_tdd.CUDAcpl(actual)
+
+    compare("test21", expected, actual)
+
+    out = np.empty((2,3,2,2), dtype = np.complex128)
+    a_tdd.numpy(out)
+    compare("test21 numpy", expected, CUDAcpl.np2CUDAcpl(out))
+
+def test22():
+    '''
+    sparse tensor ingestion
+    '''
+    indices = torch.tensor([[0,1,1],[1,0,2],[0,1,1],[1,1,0]])
+    values = torch.tensor([1+2j, -1j, 0.5, 3], dtype = torch.complex128)
+    dense = torch.zeros((2,2,3), dtype = torch.complex128)
+    for i in range(indices.shape[0]):
+        dense[tuple(indices[i])] += values[i]
+    expected = torch.view_as_real(dense)
+
+    actual = TDD.as_sparse((indices, values, (2,2,3)), [2,0,1]).CUDAcpl()
+    compare("test22", expected, actual)
+
+    actual = TDD.as_sparse(torch.sparse_coo_tensor(indices.T, values, (2,2,3))).CUDAcpl()
+    compare("test22 torch sparse", expected, actual)
+
+def test23():
+    '''
+    sampling from the state tdd
+    '''
+    a = torch.rand((2,3,2,2), dtype = torch.double)
+    probs = a[...,0]**2 + a[...,1]**2
+    probs = probs / probs.sum()
+
+    a_tdd = TDD.as_tensor((a, 0, [1,2,0]))
+    num_samples = 200000
+    samples = a_tdd.sample(num_samples, seed = 1)
+    flat = (samples[:,0]*3 + samples[:,1])*2 + samples[:,2]
+    counts = torch.bincount(flat, minlength = 12).reshape((2,3,2)).double()
+    freqs = counts / num_samples
+
+    # statistical error of the frequencies
+    max_diff = torch.max(torch.abs(freqs - probs))
+    if ( max_diff > 1e-2):
+        print("not passed: test23, diff: ",max_diff)
+    else:
+        print("passed: test23, diff: ",max_diff)
+
+def test24():
+    '''
+    complex128 buffer import and export
+    '''
+    a = np.random.rand(2,3,2) + 1j*np.random.rand(2,3,2)
+    expected = CUDAcpl.np2CUDAcpl(a)
+
+    # a non-contiguous view is read in place
+    a_T = a.transpose(2,0,1)
+    actual = TDD.as_tensor((a_T, 0, [1,2,0])).numpy().transpose(1,2,0)
+    compare("test24", expected, CUDAcpl.np2CUDAcpl(actual))
+
+    actual = TDD.as_tensor(torch.from_numpy(a)).numpy()
+    compare("test24 torch complex", expected, CUDAcpl.np2CUDAcpl(actual))
+
+    # the buffers of negative or odd strides are copied instead of read in place
+    actual = TDD.as_tensor(a[::-1]).numpy()[::-1]
+    compare("test24 negative strides", expected, CUDAcpl.np2CUDAcpl(actual.copy()))
+
+    packed = np.zeros((2,3,2), dtype = [("flag", np.uint8), ("value", np.complex128)])
+    TDD.as_tensor(a).numpy(out = packed["value"])
+    compare("test24 packed out", expected, CUDAcpl.np2CUDAcpl(packed["value"].copy()))
+
+def test25():
+    '''
+    whole circuit simulated in C++
+    '''
+    h = np.array([[1,1],[1,-1]])/np.sqrt(2)
+    cx = np.array([[1,0,0,0],[0,1,0,0],[0,0,0,1],[0,0,1,0]])
+    rz = np.diag([np.exp(-0.15j), np.exp(0.15j)])
+    u = np.kron(np.eye(2), rz) @ cx[[0,2,1,3]][:,[0,2,1,3]] @ np.kron(h, np.eye(2))
+    expected = CUDAcpl.np2CUDAcpl(u.reshape(2,2,2,2))
+
+    actual = TDD.circuit(2, [("h", [0]), ("cx", [1, 0]), ("rz", [1], [0.3])]).CUDAcpl()
+    compare("test25", expected, actual)
+
+    actual = TDD.circuit(2, [(h, [0]), (cx, [1, 0]), (rz, [1])], state=True).CUDAcpl()
+    compare("test25 state", CUDAcpl.np2CUDAcpl(u[:,0].reshape(2,2)), actual)
+
+def test26():
+    '''
+    native methods of the tdd object
+    '''
+    a = torch.rand((2,3,2,2), dtype=torch.double)
+    tdd_a = TDD.as_tensor(a)
+
+    expected = CUDAcpl.einsum1("ijk->kij", a)
+    actual = tdd_a.permute([2,0,1]).CUDAcpl()
+    compare("test26 permute", expected, actual)
+
+    expected = CUDAcpl.conj(a.select(1, 2))
+    actual = tdd_a.slice([1], [2]).conj().CUDAcpl()
+    compare("test26 slice conj", expected, actual)
+
+def test27():
+    '''
+    asynchronous operations awaited in asyncio
+    '''
+    a = torch.rand((3,2,4,2), dtype=torch.double)
+    b = torch.rand((4,3,2,2), dtype=torch.double)
+    expected = CUDAcpl.einsum("iak,akj->ij", a, b)
+
+    async def run():
+        tdd_a, tdd_b = await asyncio.gather(asyncio.wrap_future(TDD.as_tensor_async(a)),
+                                            asyncio.wrap_future(TDD.as_tensor_async(b)))
+        res = await asyncio.wrap_future(TDD.tensordot_async(tdd_a, tdd_b, [[1,2],[1,0]]))
+        return res.CUDAcpl()
+
+    actual = asyncio.run(run())
+    compare("test27", expected, actual)
+
+    # the future can also be waited synchronously
+    actual = TDD.tensordot_async(TDD.as_tensor(a), TDD.as_tensor(b), [[1,2],[1,0]]).result().CUDAcpl()
+    compare("test27 result", expected, actual)
+
+def test28():
+    '''
+    tdds from native complex tensors
+    '''
+    a = torch.rand((3,2,4), dtype=torch.complex128)
+    b = torch.rand((3,4,2), dtype=torch.complex128)
+    a_cpl = torch.view_as_real(a).contiguous()
+    b_cpl = torch.view_as_real(b).contiguous()
+
+    compare("test28 scalar weight", TDD.as_tensor(a_cpl).CUDAcpl(), TDD.as_tensor(a).CUDAcpl())
+
+    # the tensor weights are multiplied on the native complex path if it is enabled
+    expected = TDD.tensordot(TDD.as_tensor((a_cpl,1,[])), TDD.as_tensor((b_cpl,1,[])), [[1],[0]]).CUDAcpl()
+    actual = TDD.tensordot(TDD.as_tensor((a,1,[])), TDD.as_tensor((b,1,[])), [[1],[0]]).CUDAcpl()
+    compare("test28 tensor weight", expected, actual)
+    compare("test28 tensor weight CUDAcpl", CUDAcpl.einsum("iak,ikj->iaj", a_cpl, b_cpl), actual)
+
 
 
 